@@ -0,0 +1,62 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "protocol.h"
+
+// Klient serwera (server.cpp), do testów lokalnych.
+// budowanie: g++ -O2 -std=c++17 client.cpp -o client
+// użycie:    ./client /tmp/cvrptw.sock solomon_100/C101.txt [key value ...]
+//            ./client /tmp/cvrptw.sock --hash <hex> [key value ...]
+// key value are the request options of protocol.h, e.g. time-limit 5 seed 3
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <socket path> (<instance file> | --hash <hex>) [key value ...]\n";
+        return 1;
+    }
+    std::string path = argv[1];
+    std::string request, instance;
+    int a = 2;
+    if (std::string(argv[a]) == "--hash" && a + 1 < argc) {
+        request += std::string("instance-hash ") + argv[a + 1] + "\n";
+        a += 2;
+    }
+    else {
+        std::ifstream file(argv[a++]);
+        if (!file) {
+            std::cerr << "Error opening file.\n";
+            return 1;
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        instance = "instance\n" + content.str();
+    }
+    for (; a + 1 < argc; a += 2) request += std::string(argv[a]) + " " + argv[a + 1] + "\n";
+    request += instance;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (fd < 0 || path.size() >= sizeof address.sun_path) {
+        std::cerr << "Cannot create socket.\n";
+        return 1;
+    }
+    path.copy(address.sun_path, path.size());
+    if (connect(fd, (sockaddr*)&address, sizeof address) < 0) {
+        std::cerr << "Cannot connect to " << path << ".\n";
+        return 1;
+    }
+    std::string response;
+    if (!cvrptw::write_message(fd, request) || !cvrptw::read_message(fd, response)) {
+        std::cerr << "Connection closed by the server.\n";
+        return 1;
+    }
+    close(fd);
+    std::cout << response;
+    return response.compare(0, 2, "ok") == 0 ? 0 : 2;
+}
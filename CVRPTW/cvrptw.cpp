@@ -0,0 +1,4241 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
+#include <ctime>
+#include <limits>
+#include <chrono>
+#include <queue>
+#include <deque>
+#include <set>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+
+#include <stdexcept>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <new>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cvrptw.h"
+
+namespace cvrptw {
+
+struct Route {
+    std::vector<int> sequence;
+    int load = 0;
+    double cost = 0.0;
+    // bounding box of the customers, refreshed whenever the route changes
+    // (update_route_bounds)
+    double min_x = 0.0, max_x = 0.0, min_y = 0.0, max_y = 0.0;
+    double longest_edge = 0.0;
+    // total waiting time, cost - travel - service
+    double waiting = 0.0;
+    // XOR of the arc keys of the route, see route_hash
+    uint64_t hash = 0;
+    // penalty-mode only: lateness of the route and its share of cost
+    double time_warp = 0.0;
+    double penalty = 0.0;
+};
+
+// do tabu search klasa i funckje pomocnicze
+enum class MoveType { swap, insert, cross };
+
+// change of the solution cost made by a move; in penalty mode also the change of
+// total lateness and overload, so the cost can follow new penalty weights
+struct ExchangeDelta {
+    double cost = 0.0;
+    double time_warp = 0.0, excess = 0.0;
+};
+
+class Move {
+public:
+    MoveType type;
+    int a, b, route1, route2;
+    // segment lengths, used only by cross moves
+    int len1 = 0, len2 = 0;
+    double cost;
+    double time_warp = 0.0, excess = 0.0;
+    // move constuctors
+    Move() = default;
+    Move(MoveType o_type, int x, int routex, int y, int routey, const ExchangeDelta& delta)
+        : type(o_type), a(x), b(y), route1(routex), route2(routey), cost(delta.cost), time_warp(delta.time_warp), excess(delta.excess) {};
+    Move(MoveType o_type, int x, int routex, int lenx, int y, int routey, int leny, const ExchangeDelta& delta)
+        : type(o_type), a(x), b(y), route1(routex), route2(routey), len1(lenx), len2(leny),
+          cost(delta.cost), time_warp(delta.time_warp), excess(delta.excess) {};
+};
+
+// 64-byte aligned storage: arrays start on a cache line and take aligned SIMD loads
+template <class T>
+struct AlignedAllocator {
+    using value_type = T;
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(64))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(64)); }
+    bool operator==(const AlignedAllocator&) const { return true; }
+    bool operator!=(const AlignedAllocator&) const { return false; }
+};
+
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Customers as one aligned array per field. The hot loops read one or two fields
+// of many customers and so stream through contiguous memory of just those fields.
+// table[i] assembles a Customer for code that wants the whole record; when only
+// one field of it is read the compiler loads only that one.
+class CustomerTable {
+public:
+    CustomerTable() = default;
+    explicit CustomerTable(const std::vector<Customer>& customers) {
+        for (auto& c : customers) push_back(c);
+    }
+
+    size_t size() const { return id.size(); }
+
+    // const, so that table[i] = c does not compile silently
+    const Customer operator[](size_t i) const { return Customer(id[i], x[i], y[i], demand[i], ready[i], due[i], service[i]); }
+
+    void push_back(const Customer& c) {
+        id.push_back(c.id);
+        x.push_back(c.x);
+        y.push_back(c.y);
+        demand.push_back(c.demand);
+        ready.push_back(c.ready);
+        due.push_back(c.due);
+        service.push_back(c.service);
+    }
+
+    void set(size_t i, const Customer& c) {
+        id[i] = c.id;
+        x[i] = c.x;
+        y[i] = c.y;
+        demand[i] = c.demand;
+        ready[i] = c.ready;
+        due[i] = c.due;
+        service[i] = c.service;
+    }
+
+    AlignedVector<int> id;
+    AlignedVector<double> x, y;
+    AlignedVector<int> demand;
+    AlignedVector<double> ready, due, service;
+};
+
+double euclidean_distance(const Customer& a, const Customer& b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+// Distance matrix
+DistanceMatrix distance_matrix(const CustomerTable& customers) {
+    int n = customers.size();
+    DistanceMatrix distances(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            distances[i][j] = euclidean_distance(customers[i], customers[j]);
+    return distances;
+}
+
+// Euclidean distances computed when asked for, for instances whose n x n matrix
+// would not fit in memory (8 GB at 32k customers). Indexed as distance[from][to]
+// like DistanceMatrix, so the templated search code runs on either one.
+class CoordinateDistances {
+public:
+    explicit CoordinateDistances(const CustomerTable& customers) : x(customers.x), y(customers.y) {}
+
+    struct Row {
+        const double* x;
+        const double* y;
+        double xi, yi;
+        // same expression as euclidean_distance, so both providers give the same values
+        double operator[](size_t j) const { return std::sqrt((xi - x[j]) * (xi - x[j]) + (yi - y[j]) * (yi - y[j])); }
+    };
+
+    Row operator[](size_t i) const { return { x.data(), y.data(), x[i], y[i] }; }
+    size_t size() const { return x.size(); }
+
+    // out[j] = distance from i to every j, four (AVX) or two (SSE2) at a time
+    void row(size_t i, double* out) const {
+        size_t n = x.size(), j = 0;
+#if defined(__AVX__)
+        __m256d xi = _mm256_set1_pd(x[i]), yi = _mm256_set1_pd(y[i]);
+        for (; j + 4 <= n; j += 4) {
+            __m256d dx = _mm256_sub_pd(xi, _mm256_load_pd(&x[j]));
+            __m256d dy = _mm256_sub_pd(yi, _mm256_load_pd(&y[j]));
+            _mm256_storeu_pd(out + j, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128d xi = _mm_set1_pd(x[i]), yi = _mm_set1_pd(y[i]);
+        for (; j + 2 <= n; j += 2) {
+            __m128d dx = _mm_sub_pd(xi, _mm_load_pd(&x[j]));
+            __m128d dy = _mm_sub_pd(yi, _mm_load_pd(&y[j]));
+            _mm_storeu_pd(out + j, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+        }
+#endif
+        Row r = (*this)[i];
+        for (; j < n; j++) out[j] = r[j];
+    }
+
+private:
+    AlignedVector<double> x, y;
+};
+
+template <class Distance>
+std::pair<bool, double> route_feasible_and_cost(const CustomerTable& customers, int depot_index, const Distance& distance, const std::vector<int>& route_indexes) {
+    double time = 0.0;
+    double cost = 0.0;
+    int prev = depot_index;
+    const double* ready = customers.ready.data();
+    const double* due = customers.due.data();
+    const double* service = customers.service.data();
+
+    for (int index : route_indexes) {
+        double travel = distance[prev][index];
+
+        cost += travel;
+        time = time + travel;
+
+        // pracownik był za wcześnie
+        double wait_time = 0.0;
+        if (time < ready[index]) {
+            wait_time = ready[index] - time;
+            time = ready[index];
+        }
+
+        // pracownik nie zdążył
+        if (time > due[index]) {
+            return { false, 0.0 };
+        }
+
+        // Obliczanie czasu i kosztu po wykonanej usłudze
+        cost += wait_time;
+        cost += service[index];
+        time += service[index];
+
+        prev = index;
+    }
+
+    // powrót do depotu
+    double travel_to_depot = distance[prev][depot_index];
+    cost += travel_to_depot;
+    time += travel_to_depot;
+
+    if (time > due[depot_index]) {
+        return { false, 0.0 };
+    }
+
+    return { true, cost };
+}
+
+// Remove any routes that have empty sequence from a solution
+void remove_empty_routes(std::vector<Route>& solution) {
+    solution.erase(std::remove_if(solution.begin(), solution.end(), [](const Route& r) {
+        return r.sequence.empty();
+    }), solution.end());
+}
+
+// counting cost of specyfic solution
+template <class Distance>
+double totalCostCount(const std::vector<Route>& routes, const CustomerTable& customers, const Distance& distances) {
+    double total_cost = 0.0;
+    for (auto& r : routes) {
+        auto fc = route_feasible_and_cost(customers, 0, distances, r.sequence);
+        total_cost += fc.second;
+    }
+    return total_cost;
+}
+
+// number as std::cout prints it by default (6 significant digits)
+std::string format_cost(double value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+// --- segment concatenation ---
+// Summary of a consecutive part of a route, so that routes built from
+// pieces of other routes can be evaluated in O(1) instead of walking them.
+// Starting the segment at time t gives end time max(t, earliest) + duration,
+// it is feasible when t <= latest and time_warp == 0.
+struct Segment {
+    int first = -1, last = -1;   // customer indexes at both ends, -1 for an empty segment
+    double duration = 0.0;       // travel + waiting + service inside the segment
+    double earliest = 0.0;       // earliest start without extra waiting
+    double latest = 0.0;         // latest start without being late anywhere
+    double time_warp = 0.0;      // lateness that cannot be avoided (0 when feasible)
+    int load = 0;
+};
+
+constexpr double TIME_EPS = 1e-9;
+
+Segment single_segment(const Customer& customer, int index) {
+    Segment s;
+    s.first = s.last = index;
+    s.duration = customer.service;
+    s.earliest = customer.ready;
+    s.latest = customer.due;
+    s.load = customer.demand;
+    return s;
+}
+
+// vehicle leaves the depot at time 0, same as in route_feasible_and_cost
+Segment depot_start_segment(int depot_index) {
+    Segment s;
+    s.first = s.last = depot_index;
+    return s;
+}
+
+Segment depot_end_segment(const Customer& depot, int depot_index) {
+    Segment s;
+    s.first = s.last = depot_index;
+    s.earliest = depot.ready;
+    s.latest = depot.due;
+    return s;
+}
+
+template <class Distance>
+Segment concat_segments(const Segment& a, const Segment& b, const Distance& distance) {
+    if (a.first < 0) return b;
+    if (b.first < 0) return a;
+    double travel = distance[a.last][b.first];
+    double delta = a.duration - a.time_warp + travel;
+    double delta_wait = std::max(b.earliest - delta - a.latest, 0.0);
+    double delta_warp = std::max(a.earliest + delta - b.latest, 0.0);
+
+    Segment s;
+    s.first = a.first;
+    s.last = b.last;
+    s.duration = a.duration + b.duration + travel + delta_wait;
+    s.time_warp = a.time_warp + b.time_warp + delta_warp;
+    s.earliest = std::max(b.earliest - delta, a.earliest) - delta_wait;
+    s.latest = std::min(b.latest - delta, a.latest) + delta_warp;
+    s.load = a.load + b.load;
+    return s;
+}
+
+// cost of a full depot-to-depot segment, equal to route_feasible_and_cost().second
+double segment_cost(const Segment& s) {
+    return std::max(0.0, s.earliest) + s.duration;
+}
+
+bool segment_feasible(const Segment& s) {
+    return s.time_warp <= TIME_EPS;
+}
+
+// prefix[k] = depot + first k customers, suffix[k] = customers from k on + depot
+struct RouteSegments {
+    std::vector<Segment> prefix, suffix;
+    Segment full;   // the whole route, depot to depot
+};
+
+template <class Distance>
+RouteSegments build_route_segments(const CustomerTable& customers, int depot_index,
+    const Distance& distance, const std::vector<int>& sequence) {
+    int len = sequence.size();
+    RouteSegments rs;
+    rs.prefix.resize(len + 1);
+    rs.suffix.resize(len + 1);
+    rs.prefix[0] = depot_start_segment(depot_index);
+    for (int k = 0; k < len; k++)
+        rs.prefix[k + 1] = concat_segments(rs.prefix[k], single_segment(customers[sequence[k]], sequence[k]), distance);
+    rs.suffix[len] = depot_end_segment(customers[depot_index], depot_index);
+    for (int k = len - 1; k >= 0; k--)
+        rs.suffix[k] = concat_segments(single_segment(customers[sequence[k]], sequence[k]), rs.suffix[k + 1], distance);
+    rs.full = concat_segments(rs.prefix[0], rs.suffix[0], distance);
+    return rs;
+}
+
+// k nearest customers of every customer (depot excluded); with asymmetric travel
+// times a customer is near when it is cheap to reach or to come from
+template <class Distance>
+std::vector<std::vector<int>> build_neighbor_lists(const Distance& distance, int depot_index, int k) {
+    int n = distance.size();
+    std::vector<std::vector<int>> neighbors(n);
+    std::vector<int> order;
+    for (int i = 0; i < n; i++) {
+        if (i == depot_index) continue;
+        order.clear();
+        for (int j = 0; j < n; j++)
+            if (j != i && j != depot_index) order.push_back(j);
+        int take = std::min<int>(k, order.size());
+        std::partial_sort(order.begin(), order.begin() + take, order.end(),
+            [&](int a, int b) { return std::min(distance[i][a], distance[a][i]) < std::min(distance[i][b], distance[b][i]); });
+        neighbors[i].assign(order.begin(), order.begin() + take);
+    }
+    return neighbors;
+}
+
+// the same from one vectorized row of distances per customer, O(n) memory
+std::vector<std::vector<int>> build_neighbor_lists(const CoordinateDistances& distance, int depot_index, int k) {
+    int n = distance.size();
+    std::vector<std::vector<int>> neighbors(n);
+    std::vector<double> row(n);
+    std::vector<int> order;
+    for (int i = 0; i < n; i++) {
+        if (i == depot_index) continue;
+        distance.row(i, row.data());
+        order.clear();
+        for (int j = 0; j < n; j++)
+            if (j != i && j != depot_index) order.push_back(j);
+        int take = std::min<int>(k, order.size());
+        auto closer = [&](int a, int b) { return row[a] < row[b]; };
+        if (take < (int)order.size()) std::nth_element(order.begin(), order.begin() + take, order.end(), closer);
+        std::sort(order.begin(), order.begin() + take, closer);
+        neighbors[i].assign(order.begin(), order.begin() + take);
+    }
+    return neighbors;
+}
+
+// n x n bitset answering "can customer j be visited right after customer i".
+// Windows are first tightened by depot reachability: service cannot start before
+// the vehicle can arrive from the depot, nor so late that it cannot get back.
+class TimeWindowCompatibility {
+public:
+    TimeWindowCompatibility() = default;
+    template <class Distance>
+    TimeWindowCompatibility(const CustomerTable& customers, int depot_index, const Distance& distance) {
+        n = rows = customers.size();
+        words = (n + 63) / 64;
+        bits.assign((size_t)n * words, 0);
+        const Customer& depot = customers[depot_index];
+        std::vector<double> earliest(n), latest(n);
+        for (int i = 0; i < n; i++) {
+            earliest[i] = std::max(customers[i].ready, distance[depot_index][i]);
+            latest[i] = std::min(customers[i].due, depot.due - distance[i][depot_index] - customers[i].service);
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t* row = &bits[(size_t)i * words];
+            for (int j = 0; j < n; j++) {
+                bool ok = i == depot_index || j == depot_index ||
+                    (i != j && earliest[i] + customers[i].service + distance[i][j] <= latest[j]);
+                if (ok) row[j >> 6] |= uint64_t(1) << (j & 63);
+            }
+        }
+    }
+
+    bool can_follow(int i, int j) const {
+        return (bits[(size_t)i * words + (j >> 6)] >> (j & 63)) & 1;
+    }
+
+    // Recomputes row and column of customer i after it was added (i == n) or changed,
+    // O(n). Storage grows by doubling, so adding customers one by one stays O(n) amortized.
+    template <class Distance>
+    void update(const CustomerTable& customers, int depot_index, const Distance& distance, int i) {
+        if ((int)customers.size() > rows) grow(std::max<int>(customers.size(), 2 * rows));
+        n = customers.size();
+        const Customer& depot = customers[depot_index];
+        auto earliest = [&](int k) { return std::max(customers[k].ready, distance[depot_index][k]); };
+        auto latest = [&](int k) { return std::min(customers[k].due, depot.due - distance[k][depot_index] - customers[k].service); };
+        for (int j = 0; j < n; j++) {
+            set(i, j, i == depot_index || j == depot_index || (i != j && earliest(i) + customers[i].service + distance[i][j] <= latest(j)));
+            set(j, i, i == depot_index || j == depot_index || (i != j && earliest(j) + customers[j].service + distance[j][i] <= latest(i)));
+        }
+    }
+
+private:
+    void set(int i, int j, bool ok) {
+        uint64_t& word = bits[(size_t)i * words + (j >> 6)];
+        uint64_t mask = uint64_t(1) << (j & 63);
+        if (ok) word |= mask;
+        else word &= ~mask;
+    }
+
+    void grow(int new_rows) {
+        int new_words = (new_rows + 63) / 64;
+        std::vector<uint64_t> grown((size_t)new_rows * new_words, 0);
+        for (int i = 0; i < n; i++)
+            std::copy(&bits[(size_t)i * words], &bits[(size_t)i * words] + words, &grown[(size_t)i * new_words]);
+        bits = std::move(grown);
+        rows = new_rows;
+        words = new_words;
+    }
+
+    int n = 0, rows = 0, words = 0;
+    std::vector<uint64_t> bits;
+};
+
+// Lower bounds used for reporting the gap and for early termination.
+// vehicles: capacity bin-packing bound and the largest clique of customers that
+// pairwise cannot share a route (greedy, so a valid but not the best clique bound).
+// cost: every route cost includes service, one incoming arc per customer and a
+// return to the depot, so service + cheapest incoming arcs + vehicles * cheapest return;
+// or, as clique customers are on separate routes, the sum of their earliest returns;
+// or the capacity packing of earliest returns below. None of them sees waiting or
+// detours forced by time windows, so on wide-horizon instances the bound stays far
+// below good solutions.
+struct LowerBounds {
+    int capacity_vehicles = 1;
+    int time_window_vehicles = 1;
+    double cost = 0.0;
+    int vehicles() const { return std::max(capacity_vehicles, time_window_vehicles); }
+};
+
+// The clique and the earliest returns take d[0][i] as the earliest arrival and d[i][0]
+// as the fastest way back, which needs the triangle inequality; with an external
+// matrix (euclidean false) a detour may be faster, so only the arc bound is used.
+template <class Distance>
+LowerBounds compute_lower_bounds(const CustomerTable& customers, int depot_index,
+    const Distance& distance, double capacity, const TimeWindowCompatibility& compatible, bool euclidean) {
+    LowerBounds lb;
+    int n = customers.size();
+    double total_demand = 0.0;
+    for (int i = 0; i < n; i++) if (i != depot_index) total_demand += customers[i].demand;
+    lb.capacity_vehicles = std::max(1, (int)std::ceil(total_demand / capacity - 1e-9));
+
+    double cheapest_return = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < n; i++) {
+        if (i == depot_index) continue;
+        double cheapest_in = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < n; j++) if (j != i) cheapest_in = std::min(cheapest_in, distance[j][i]);
+        lb.cost += customers[i].service + cheapest_in;
+        cheapest_return = std::min(cheapest_return, distance[i][depot_index]);
+    }
+    if (!euclidean) {
+        lb.cost += lb.vehicles() * cheapest_return;
+        return lb;
+    }
+
+    auto conflict = [&](int i, int j) { return !compatible.can_follow(i, j) && !compatible.can_follow(j, i); };
+    std::vector<int> degree(n, 0), order;
+    for (int i = 0; i < n; i++) {
+        if (i == depot_index) continue;
+        for (int j = i + 1; j < n; j++)
+            if (j != depot_index && conflict(i, j)) {
+                degree[i]++;
+                degree[j]++;
+            }
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return degree[a] > degree[b]; });
+    auto earliest_return = [&](int i) {
+        return std::max(customers[i].ready, distance[depot_index][i]) + customers[i].service + distance[i][depot_index];
+    };
+    double clique_cost = 0.0;
+    for (int s = 0; s < std::min<int>(20, order.size()); s++) {
+        std::vector<int> clique = { order[s] };
+        for (int v : order) {
+            if (v == order[s] || degree[v] < (int)clique.size()) continue;
+            bool all = true;
+            for (int u : clique) all &= conflict(u, v);
+            if (all) clique.push_back(v);
+        }
+        lb.time_window_vehicles = std::max<int>(lb.time_window_vehicles, clique.size());
+        double returns = 0.0;
+        for (int v : clique) returns += earliest_return(v);
+        clique_cost = std::max(clique_cost, returns);
+    }
+
+    lb.cost += lb.vehicles() * cheapest_return;
+
+    // A route costs at least the earliest return of each of its customers. With routes
+    // ordered by that maximum, customers returning later than the (k+1)-th one all sit
+    // on the first k routes and fit into k * capacity, so taking customers by
+    // decreasing earliest return, the route at cumulative demand k * capacity
+    // contributes the return of that customer.
+    std::vector<int> by_return = order;
+    std::sort(by_return.begin(), by_return.end(), [&](int a, int b) { return earliest_return(a) > earliest_return(b); });
+    double packed_cost = 0.0, load = 0.0;
+    int packed_routes = 0;
+    for (int v : by_return) {
+        load += customers[v].demand;
+        while (packed_routes == 0 || load > packed_routes * capacity + 1e-9) {
+            packed_cost += earliest_return(v);
+            packed_routes++;
+        }
+    }
+    if (!by_return.empty())
+        for (; packed_routes < lb.vehicles(); packed_routes++) packed_cost += earliest_return(by_return.back());
+
+    lb.cost = std::max({ lb.cost, clique_cost, packed_cost });
+    return lb;
+}
+
+// relative gap of a cost to the lower bound, in percent
+double gap_percent(double cost, const LowerBounds& lb) {
+    return lb.cost > 0.0 ? 100.0 * (cost - lb.cost) / lb.cost : 0.0;
+}
+
+// dane instancji potrzebne generatorom ruchów; Distance is DistanceMatrix or
+// CoordinateDistances, both indexed as distance[from][to]
+template <class Distance>
+struct ProblemData {
+    const CustomerTable& customers;
+    int depot_index;
+    const Distance& distance;
+    double capacity;
+    const std::vector<std::vector<int>>& neighbors;
+    const TimeWindowCompatibility& compatible;
+    // distances are the Euclidean ones of the coordinates, geometric pruning is valid
+    bool euclidean = true;
+};
+
+// current solution together with its segment summaries and customer positions
+// Weights of the infeasible-space search. When enabled, capacity excess and time
+// warp are allowed and added to the route cost instead of rejecting the route.
+struct Penalties {
+    bool enabled = false;
+    double time_warp = 10.0;
+    double capacity = 100.0;
+};
+
+struct SearchState {
+    std::vector<Route> routes;
+    std::vector<RouteSegments> segments;
+    std::vector<int> route_of, position_of;
+    Penalties penalty;
+};
+
+double route_penalty(const Segment& full, const Penalties& penalty, double capacity) {
+    if (!penalty.enabled) return 0.0;
+    return penalty.time_warp * full.time_warp + penalty.capacity * std::max(0.0, full.load - capacity);
+}
+
+bool solution_feasible(const std::vector<Route>& routes, double capacity) {
+    for (auto& r : routes)
+        if (r.time_warp > TIME_EPS || r.load > capacity) return false;
+    return true;
+}
+
+template <class Distance>
+void update_route_bounds(const ProblemData<Distance>& data, Route& route) {
+    const CustomerTable& customers = data.customers;
+    if (route.sequence.empty()) return;
+    const Customer& first = customers[route.sequence[0]];
+    route.min_x = route.max_x = first.x;
+    route.min_y = route.max_y = first.y;
+    route.longest_edge = 0.0;
+    double travel = 0.0, service = 0.0;
+    int prev = data.depot_index;
+    for (int index : route.sequence) {
+        const Customer& c = customers[index];
+        travel += data.distance[prev][index];
+        service += c.service;
+        route.min_x = std::min(route.min_x, c.x);
+        route.max_x = std::max(route.max_x, c.x);
+        route.min_y = std::min(route.min_y, c.y);
+        route.max_y = std::max(route.max_y, c.y);
+        route.longest_edge = std::max(route.longest_edge, data.distance[prev][index]);
+        prev = index;
+    }
+    route.longest_edge = std::max(route.longest_edge, data.distance[prev][data.depot_index]);
+    travel += data.distance[prev][data.depot_index];
+    route.waiting = std::max(0.0, route.cost - travel - service);
+}
+
+// Cheap test done before any per-customer evaluation of a route pair, a lower
+// bound on the delta of every move between the two routes (Euclidean distances only).
+// A move takes at most two junction edges out of each route, each no longer than the
+// longest edge of its route. Both routes cannot be replaced as a whole, so at least
+// one new edge joins customers of the two routes and is at least as long as the gap
+// between their bounding boxes. Service time only moves between the routes and the
+// waiting of both can at most drop to 0.
+bool route_pair_may_improve(const Route& a, const Route& b, bool euclidean) {
+    if (!euclidean) return true;
+    double gap_x = std::max(0.0, std::max(a.min_x - b.max_x, b.min_x - a.max_x));
+    double gap_y = std::max(0.0, std::max(a.min_y - b.max_y, b.min_y - a.max_y));
+    double gap = std::sqrt(gap_x * gap_x + gap_y * gap_y);
+    return gap - 2.0 * (a.longest_edge + b.longest_edge) - a.waiting - b.waiting < 0.0;
+}
+
+uint64_t mix_hash(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Hash of a route as the XOR of random keys of its arcs. The solution hash is the
+// XOR of route hashes, so it does not depend on route order and a move updates it
+// by XOR-ing out the two old routes and XOR-ing in the two new ones.
+uint64_t route_hash(int depot_index, const std::vector<int>& sequence) {
+    uint64_t h = 0;
+    int prev = depot_index;
+    for (int index : sequence) {
+        h ^= mix_hash(((uint64_t)prev << 32) | (uint32_t)index);
+        prev = index;
+    }
+    if (!sequence.empty()) h ^= mix_hash(((uint64_t)prev << 32) | (uint32_t)depot_index);
+    return h;
+}
+
+uint64_t solution_hash(const std::vector<Route>& routes) {
+    uint64_t h = 0;
+    for (auto& r : routes) h ^= r.hash;
+    return h;
+}
+
+// order-independent hash of the customers of a route
+uint64_t customer_set_hash(const std::vector<int>& customers) {
+    uint64_t h = 0;
+    for (int index : customers) h ^= mix_hash((uint64_t)index + 0x51ed27u);
+    return h;
+}
+
+template <class Distance>
+void refresh_route(const ProblemData<Distance>& data, SearchState& state, int r) {
+    const std::vector<int>& seq = state.routes[r].sequence;
+    state.segments[r] = build_route_segments(data.customers, data.depot_index, data.distance, seq);
+    const Segment& full = state.segments[r].full;
+    state.routes[r].time_warp = full.time_warp;
+    state.routes[r].penalty = route_penalty(full, state.penalty, data.capacity);
+    state.routes[r].cost = segment_cost(full) + state.routes[r].penalty;
+    update_route_bounds(data, state.routes[r]);
+    state.routes[r].hash = route_hash(data.depot_index, seq);
+    for (int k = 0; k < (int)seq.size(); k++) {
+        state.route_of[seq[k]] = r;
+        state.position_of[seq[k]] = k;
+    }
+}
+
+template <class Distance>
+void refresh_all_routes(const ProblemData<Distance>& data, SearchState& state) {
+    state.segments.assign(state.routes.size(), RouteSegments());
+    state.route_of.assign(data.customers.size(), -1);
+    state.position_of.assign(data.customers.size(), -1);
+    for (int r = 0; r < (int)state.routes.size(); r++) refresh_route(data, state, r);
+}
+
+// Exchange of segment [i, i+len1) of route1 with segment [j, j+len2) of route2.
+// Swap is (1, 1), insert is (1, 0), anything longer is a CROSS move.
+// Filters go from cheapest to most expensive: capacity, junction compatibility,
+// O(1) lower bound against the cutoff, and only then the time-window evaluation.
+// Returns false when the move is infeasible or cannot beat the cutoff.
+template <class Distance>
+bool evaluate_exchange(const ProblemData<Distance>& data, const SearchState& state, int route1, int i, const Segment& part1,
+    int len1, int route2, int j, const Segment& part2, int len2, double cutoff, ExchangeDelta& delta) {
+    const Route& r1 = state.routes[route1];
+    const Route& r2 = state.routes[route2];
+    // exchanging two whole routes only swaps their labels
+    if (len1 == (int)r1.sequence.size() && len2 == (int)r2.sequence.size()) return false;
+    bool hard = !state.penalty.enabled;
+    if (hard && r1.load - part1.load + part2.load > data.capacity) return false;
+    if (hard && r2.load - part2.load + part1.load > data.capacity) return false;
+
+    // time-window compatibility of the four new junctions
+    int before1 = i > 0 ? r1.sequence[i - 1] : data.depot_index;
+    int after1 = i + len1 < (int)r1.sequence.size() ? r1.sequence[i + len1] : data.depot_index;
+    int before2 = j > 0 ? r2.sequence[j - 1] : data.depot_index;
+    int after2 = j + len2 < (int)r2.sequence.size() ? r2.sequence[j + len2] : data.depot_index;
+    if (hard && (len2 > 0 ? !data.compatible.can_follow(before1, part2.first) || !data.compatible.can_follow(part2.last, after1)
+                          : !data.compatible.can_follow(before1, after1))) return false;
+    if (hard && (len1 > 0 ? !data.compatible.can_follow(before2, part1.first) || !data.compatible.can_follow(part1.last, after2)
+                          : !data.compatible.can_follow(before2, after2))) return false;
+
+    // segments keep their inner edges, so only the junctions change the distance;
+    // service time is only moved between the routes and waiting (with penalties
+    // in penalty mode, see update_route_bounds) can at most drop to 0
+    const Distance& d = data.distance;
+    double old_edges = (len1 > 0 ? d[before1][part1.first] + d[part1.last][after1] : d[before1][after1])
+        + (len2 > 0 ? d[before2][part2.first] + d[part2.last][after2] : d[before2][after2]);
+    double new_edges = (len2 > 0 ? d[before1][part2.first] + d[part2.last][after1] : d[before1][after1])
+        + (len1 > 0 ? d[before2][part1.first] + d[part1.last][after2] : d[before2][after2]);
+    if (new_edges - old_edges - r1.waiting - r2.waiting >= cutoff) return false;
+
+    const RouteSegments& rs1 = state.segments[route1];
+    const RouteSegments& rs2 = state.segments[route2];
+    Segment new1 = concat_segments(concat_segments(rs1.prefix[i], part2, data.distance), rs1.suffix[i + len1], data.distance);
+    if (hard && !segment_feasible(new1)) return false;
+    Segment new2 = concat_segments(concat_segments(rs2.prefix[j], part1, data.distance), rs2.suffix[j + len2], data.distance);
+    if (hard && !segment_feasible(new2)) return false;
+
+    delta.cost = segment_cost(new1) + route_penalty(new1, state.penalty, data.capacity)
+        + segment_cost(new2) + route_penalty(new2, state.penalty, data.capacity) - r1.cost - r2.cost;
+    if (delta.cost >= cutoff) return false;
+    if (!hard) {
+        auto excess = [&](double load) { return std::max(0.0, load - data.capacity); };
+        delta.time_warp = new1.time_warp + new2.time_warp - r1.time_warp - r2.time_warp;
+        delta.excess = excess(new1.load) + excess(new2.load) - excess(r1.load) - excess(r2.load);
+    }
+    return true;
+}
+
+// CROSS moves from route1 to route2, seeded from neighbor lists: the segment of
+// route1 starting with customer u is placed right after its neighbor v in route2.
+template <class Distance>
+void add_cross_moves(const ProblemData<Distance>& data, const SearchState& state, int route1, int route2,
+    int max_len, double cutoff, std::vector<Move>& moves) {
+    const std::vector<int>& seq1 = state.routes[route1].sequence;
+    const std::vector<int>& seq2 = state.routes[route2].sequence;
+    for (int i = 0; i < (int)seq1.size(); i++) {
+        for (int v : data.neighbors[seq1[i]]) {
+            if (state.route_of[v] != route2) continue;
+            int j = state.position_of[v] + 1;
+
+            Segment part1;
+            for (int len1 = 1; len1 <= max_len && i + len1 <= (int)seq1.size(); len1++) {
+                int c1 = seq1[i + len1 - 1];
+                part1 = concat_segments(part1, single_segment(data.customers[c1], c1), data.distance);
+                Segment part2;
+                for (int len2 = 0; len2 <= max_len && j + len2 <= (int)seq2.size(); len2++) {
+                    if (len2 > 0) {
+                        int c2 = seq2[j + len2 - 1];
+                        part2 = concat_segments(part2, single_segment(data.customers[c2], c2), data.distance);
+                    }
+                    // plain swap and insert are generated separately
+                    if (len1 == 1 && len2 <= 1) continue;
+                    ExchangeDelta delta;
+                    if (evaluate_exchange(data, state, route1, i, part1, len1, route2, j, part2, len2, cutoff, delta))
+                        moves.push_back(Move(MoveType::cross, i, route1, len1, j, route2, len2, delta));
+                }
+            }
+        }
+    }
+}
+
+// all swap, insert and CROSS moves between two routes
+template <class Distance>
+std::vector<Move> evaluate_route_pair(const ProblemData<Distance>& data, const SearchState& state, int route1, int route2, int cross_max_len, double cutoff) {
+    std::vector<Move> moves;
+    if (!route_pair_may_improve(state.routes[route1], state.routes[route2], data.euclidean)) return moves;
+    const std::vector<int>& seq1 = state.routes[route1].sequence;
+    const std::vector<int>& seq2 = state.routes[route2].sequence;
+    const Segment empty;
+
+    for (int i = 0; i < (int)seq1.size(); i++) {
+        Segment part1 = single_segment(data.customers[seq1[i]], seq1[i]);
+        for (int j = 0; j <= (int)seq2.size(); j++) {
+            ExchangeDelta delta;
+            if (j < (int)seq2.size()) {
+                Segment part2 = single_segment(data.customers[seq2[j]], seq2[j]);
+                if (evaluate_exchange(data, state, route1, i, part1, 1, route2, j, part2, 1, cutoff, delta))
+                    moves.push_back(Move(MoveType::swap, i, route1, j, route2, delta));
+            }
+            if (evaluate_exchange(data, state, route1, i, part1, 1, route2, j, empty, 0, cutoff, delta))
+                moves.push_back(Move(MoveType::insert, i, route1, j, route2, delta));
+        }
+    }
+    for (int j = 0; j < (int)seq2.size(); j++) {
+        Segment part2 = single_segment(data.customers[seq2[j]], seq2[j]);
+        for (int i = 0; i <= (int)seq1.size(); i++) {
+            ExchangeDelta delta;
+            if (evaluate_exchange(data, state, route2, j, part2, 1, route1, i, empty, 0, cutoff, delta))
+                moves.push_back(Move(MoveType::insert, j, route2, i, route1, delta));
+        }
+    }
+    if (cross_max_len > 1) {
+        add_cross_moves(data, state, route1, route2, cross_max_len, cutoff, moves);
+        add_cross_moves(data, state, route2, route1, cross_max_len, cutoff, moves);
+    }
+    return moves;
+}
+
+// Evaluated moves kept between iterations, grouped by route pair. After a move only
+// the pairs touching its two routes are re-evaluated; old heap entries are recognised
+// by the route version stamps and dropped when they reach the top (lazy deletion).
+class MoveStore {
+public:
+    struct Entry {
+        double cost;
+        int route1, route2, index;
+        unsigned stamp1, stamp2;
+        bool operator>(const Entry& other) const { return cost > other.cost; }
+    };
+
+    explicit MoveStore(int keep_best) : keep_best(keep_best) {}
+
+    void reset(int routes) {
+        best_costs.clear();
+        other_costs.clear();
+        route_count = routes;
+        version.assign(routes, 0);
+        pair_moves.assign(routes * routes, std::vector<Move>());
+        heap = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>();
+        live = 0;
+    }
+
+    // route1 < route2
+    void set_pair(int route1, int route2, std::vector<Move> moves) {
+        clear_pair(route1, route2);
+        std::vector<Move>& slot = pair_moves[route1 * route_count + route2];
+        live += moves.size();
+        slot = std::move(moves);
+        for (int k = 0; k < (int)slot.size(); k++) {
+            heap.push({ slot[k].cost, route1, route2, k, version[route1], version[route2] });
+            track(slot[k].cost);
+        }
+    }
+
+    // cost of the keep_best-th best stored move; candidates that cannot beat it
+    // would never be picked and are not stored at all
+    double cutoff() const {
+        return (int)best_costs.size() < keep_best ? std::numeric_limits<double>::infinity() : *best_costs.rbegin();
+    }
+
+    // marks every stored move of the route as outdated and drops them, so they no
+    // longer count for the cutoff; their heap entries go lazily
+    void touch(int route) {
+        version[route]++;
+        for (int other = 0; other < route_count; other++)
+            if (other != route) clear_pair(std::min(route, other), std::max(route, other));
+    }
+
+    bool stale(const Entry& e) const {
+        return e.stamp1 != version[e.route1] || e.stamp2 != version[e.route2];
+    }
+
+    // best up-to-date entry, removed from the heap
+    bool pop_best(Entry& e) {
+        while (!heap.empty()) {
+            e = heap.top();
+            heap.pop();
+            if (!stale(e)) return true;
+        }
+        return false;
+    }
+
+    void push(const Entry& e) { heap.push(e); }
+
+    const Move& move(const Entry& e) const { return pair_moves[e.route1 * route_count + e.route2][e.index]; }
+
+    // rebuilds the heap when outdated entries dominate it
+    void compact() {
+        if (heap.size() < 4 * live + 1024) return;
+        rebuild_heap();
+    }
+
+    // penalty weights changed by the given amounts: every stored move gets its cost
+    // for the new weights, no route pair is evaluated again
+    void rescore(double time_warp_change, double capacity_change) {
+        best_costs.clear();
+        other_costs.clear();
+        for (auto& slot : pair_moves)
+            for (auto& m : slot) {
+                m.cost += time_warp_change * m.time_warp + capacity_change * m.excess;
+                track(m.cost);
+            }
+        rebuild_heap();
+    }
+
+private:
+    void rebuild_heap() {
+        std::vector<Entry> entries;
+        entries.reserve(live);
+        for (int r1 = 0; r1 < route_count; r1++)
+            for (int r2 = r1 + 1; r2 < route_count; r2++) {
+                const std::vector<Move>& slot = pair_moves[r1 * route_count + r2];
+                for (int k = 0; k < (int)slot.size(); k++)
+                    entries.push_back({ slot[k].cost, r1, r2, k, version[r1], version[r2] });
+            }
+        heap = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>(std::greater<Entry>(), std::move(entries));
+    }
+
+    void clear_pair(int route1, int route2) {
+        std::vector<Move>& slot = pair_moves[route1 * route_count + route2];
+        for (auto& m : slot) untrack(m.cost);
+        live -= slot.size();
+        slot.clear();
+    }
+
+    // best_costs holds the keep_best lowest costs of the stored moves, other_costs the rest
+    void track(double cost) {
+        if ((int)best_costs.size() < keep_best) best_costs.insert(cost);
+        else if (cost < *best_costs.rbegin()) {
+            other_costs.insert(*best_costs.rbegin());
+            best_costs.erase(std::prev(best_costs.end()));
+            best_costs.insert(cost);
+        }
+        else other_costs.insert(cost);
+    }
+
+    void untrack(double cost) {
+        auto it = other_costs.find(cost);
+        if (it != other_costs.end()) {
+            other_costs.erase(it);
+            return;
+        }
+        best_costs.erase(best_costs.find(cost));
+        if (!other_costs.empty()) {
+            best_costs.insert(*other_costs.begin());
+            other_costs.erase(other_costs.begin());
+        }
+    }
+
+    int keep_best;
+    std::multiset<double> best_costs, other_costs;
+    int route_count = 0;
+    size_t live = 0;
+    std::vector<unsigned> version;
+    std::vector<std::vector<Move>> pair_moves;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+};
+
+// lengths of the two exchanged segments, [a, a+len1) of route1 and [b, b+len2) of route2
+void move_lengths(const Move& m, int& len1, int& len2) {
+    len1 = 1, len2 = 1;
+    if (m.type == MoveType::insert) len2 = 0;
+    else if (m.type == MoveType::cross) { len1 = m.len1; len2 = m.len2; }
+}
+
+// applies a swap / insert / cross move to the solution
+void apply_move(std::vector<Route>& solution, const CustomerTable& customers, const Move& chosen) {
+    int len1, len2;
+    move_lengths(chosen, len1, len2);
+
+    std::vector<int>& seq1 = solution[chosen.route1].sequence;
+    std::vector<int>& seq2 = solution[chosen.route2].sequence;
+    std::vector<int> part1(seq1.begin() + chosen.a, seq1.begin() + chosen.a + len1);
+    std::vector<int> part2(seq2.begin() + chosen.b, seq2.begin() + chosen.b + len2);
+    int load1 = 0, load2 = 0;
+    for (int c : part1) load1 += customers[c].demand;
+    for (int c : part2) load2 += customers[c].demand;
+
+    seq1.erase(seq1.begin() + chosen.a, seq1.begin() + chosen.a + len1);
+    seq1.insert(seq1.begin() + chosen.a, part2.begin(), part2.end());
+    seq2.erase(seq2.begin() + chosen.b, seq2.begin() + chosen.b + len2);
+    seq2.insert(seq2.begin() + chosen.b, part1.begin(), part1.end());
+    solution[chosen.route1].load += load2 - load1;
+    solution[chosen.route2].load += load1 - load2;
+}
+
+// moves a few random customers to the first feasible position found in another
+// random route; used to give islands different starting points
+template <class Distance>
+void perturb_solution(const ProblemData<Distance>& data, std::vector<Route>& solution, std::mt19937& rng, int count) {
+    for (int step = 0; step < count && solution.size() > 1; step++) {
+        int from = rng() % solution.size();
+        if (solution[from].sequence.empty()) continue;
+        int pos = rng() % solution[from].sequence.size();
+        int customer = solution[from].sequence[pos];
+        int demand = data.customers[customer].demand;
+        int offset = rng() % solution.size();
+        bool moved = false;
+        for (int k = 0; k < (int)solution.size() && !moved; k++) {
+            int to = (offset + k) % solution.size();
+            if (to == from || solution[to].load + demand > data.capacity) continue;
+            std::vector<int> candidate = solution[to].sequence;
+            for (int p = 0; p <= (int)solution[to].sequence.size() && !moved; p++) {
+                candidate.insert(candidate.begin() + p, customer);
+                if (route_feasible_and_cost(data.customers, data.depot_index, data.distance, candidate).first) {
+                    solution[to].sequence = candidate;
+                    solution[to].load += demand;
+                    solution[from].sequence.erase(solution[from].sequence.begin() + pos);
+                    solution[from].load -= demand;
+                    moved = true;
+                }
+                candidate.erase(candidate.begin() + p);
+            }
+        }
+    }
+    remove_empty_routes(solution);
+}
+
+// Best solution shared between islands. Published solutions are immutable and
+// handed out as shared pointers: readers never see a half-written solution and a
+// replaced one is freed as soon as the last island holding it lets go.
+struct Incumbent {
+    std::vector<Route> routes;
+    double cost;
+    int island;
+};
+
+class IncumbentSlot {
+public:
+    IncumbentSlot() = default;
+    IncumbentSlot(const IncumbentSlot&) = delete;
+    IncumbentSlot& operator=(const IncumbentSlot&) = delete;
+
+    std::shared_ptr<const Incumbent> load() const { return std::atomic_load_explicit(&current, std::memory_order_acquire); }
+
+    // replaces the incumbent only when the new solution is better
+    bool publish(const std::vector<Route>& routes, double cost, int island) {
+        std::shared_ptr<const Incumbent> seen = load();
+        if (seen && cost >= seen->cost) return false;
+        std::shared_ptr<const Incumbent> fresh = std::make_shared<const Incumbent>(Incumbent{ routes, cost, island });
+        while (!seen || cost < seen->cost) {
+            if (std::atomic_compare_exchange_weak_explicit(&current, &seen, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+
+private:
+    std::shared_ptr<const Incumbent> current;
+};
+
+// Visited solutions by hash: open addressing, 16 bytes per entry.
+class VisitedSet {
+public:
+    struct Visit {
+        long long last = -1;   // iteration of the previous visit, -1 for a new solution
+        int count = 0;         // visits including this one
+    };
+
+    VisitedSet() { clear(); }
+
+    void clear() {
+        keys.assign(1 << 12, 0);
+        last_seen.assign(keys.size(), 0);
+        counts.assign(keys.size(), 0);
+        used = 0;
+    }
+
+    Visit record(uint64_t key, long long iteration) {
+        if (key == 0) key = 1;   // 0 marks an empty slot
+        if (2 * (used + 1) > keys.size()) grow();
+        size_t slot = find_slot(key);
+        Visit visit;
+        if (keys[slot] == key) visit.last = last_seen[slot];
+        else {
+            keys[slot] = key;
+            used++;
+        }
+        last_seen[slot] = (int)iteration;
+        visit.count = ++counts[slot];
+        return visit;
+    }
+
+    // only occupied slots are written, the table is rebuilt with the same capacity
+    void write(std::ostream& out) const {
+        out << "visited " << keys.size() << " " << used << "\n";
+        for (size_t k = 0; k < keys.size(); k++)
+            if (keys[k] != 0) out << k << " " << keys[k] << " " << last_seen[k] << " " << counts[k] << "\n";
+    }
+
+    void read(std::istream& in) {
+        std::string label;
+        size_t size;
+        if (!(in >> label >> size >> used) || label != "visited" || size == 0 || (size & (size - 1)))
+            throw std::runtime_error("Bad checkpoint, expected visited.");
+        keys.assign(size, 0);
+        last_seen.assign(size, 0);
+        counts.assign(size, 0);
+        for (size_t k = 0; k < used; k++) {
+            size_t slot;
+            in >> slot;
+            if (slot >= size) throw std::runtime_error("Bad checkpoint, visited slot out of range.");
+            in >> keys[slot] >> last_seen[slot] >> counts[slot];
+        }
+    }
+
+private:
+    size_t find_slot(uint64_t key) const {
+        size_t mask = keys.size() - 1;
+        size_t slot = key & mask;
+        while (keys[slot] != 0 && keys[slot] != key) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void grow() {
+        std::vector<uint64_t> old_keys = std::move(keys);
+        std::vector<int> old_last = std::move(last_seen);
+        std::vector<int> old_counts = std::move(counts);
+        keys.assign(old_keys.size() * 2, 0);
+        last_seen.assign(keys.size(), 0);
+        counts.assign(keys.size(), 0);
+        for (size_t k = 0; k < old_keys.size(); k++) {
+            if (old_keys[k] == 0) continue;
+            size_t slot = find_slot(old_keys[k]);
+            keys[slot] = old_keys[k];
+            last_seen[slot] = old_last[k];
+            counts[slot] = old_counts[k];
+        }
+    }
+
+    std::vector<uint64_t> keys;
+    std::vector<int> last_seen, counts;
+    size_t used = 0;
+};
+
+// Tabu attributes: customer c left route r in some iteration. For the tenure that
+// follows, no move may bring c back into r, whatever move type would do it.
+class TabuList {
+public:
+    struct Attribute {
+        int customer, route;
+        long long iteration;
+    };
+
+    void add(int customer, int route, long long iteration) {
+        order.push_back({ customer, route, iteration });
+        left_at[key(customer, route)] = iteration;
+    }
+
+    bool forbidden(int customer, int route) const { return left_at.count(key(customer, route)) > 0; }
+
+    // drops the attributes older than tenure iterations
+    void expire(long long iteration, double tenure) {
+        while (!order.empty() && iteration - order.front().iteration >= tenure) {
+            auto it = left_at.find(key(order.front().customer, order.front().route));
+            // the same pair may have been added again later
+            if (it != left_at.end() && it->second == order.front().iteration) left_at.erase(it);
+            order.pop_front();
+        }
+    }
+
+    // routes got new indices (new_index[r], -1 for a removed route)
+    void renumber(const std::vector<int>& new_index) {
+        std::deque<Attribute> old = std::move(order);
+        clear();
+        for (auto& a : old)
+            if (new_index[a.route] >= 0) add(a.customer, new_index[a.route], a.iteration);
+    }
+
+    void clear() {
+        order.clear();
+        left_at.clear();
+    }
+
+    const std::deque<Attribute>& attributes() const { return order; }
+
+private:
+    static uint64_t key(int customer, int route) { return (uint64_t)(uint32_t)customer << 32 | (uint32_t)route; }
+
+    std::deque<Attribute> order;
+    std::unordered_map<uint64_t, long long> left_at;
+};
+
+// runs fn(k) for k in [0, count) on up to threads worker threads
+void parallel_for(int threads, int count, const std::function<void(int)>& fn) {
+    std::vector<std::thread> workers;
+    std::atomic<int> next{ 0 };
+    for (int t = 0; t < std::min(threads, count); t++)
+        workers.emplace_back([&]() {
+            for (int k = next++; k < count; k = next++) fn(k);
+        });
+    for (auto& w : workers) w.join();
+}
+
+// --- DOKŁADNA OPTYMALIZACJA KRÓTKICH TRAS ---
+
+constexpr int EXACT_MAX_CUSTOMERS = 12;
+
+// Optimal order of a short route: DP over (visited subset, last customer) keeping the
+// earliest finish time, which dominates every other state with the same key since the
+// route cost is its return time. States that can no longer reach some unvisited
+// customer before its due time are dropped. Returns an empty vector if no order is feasible.
+template <class Distance>
+std::vector<int> optimal_route_order(const ProblemData<Distance>& data, const std::vector<int>& customers) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const Distance& d = data.distance;
+    int m = customers.size();
+    int full = (1 << m) - 1;
+    std::vector<double> finish((size_t)(full + 1) * m, INF);
+    std::vector<signed char> parent((size_t)(full + 1) * m, -1);
+
+    for (int k = 0; k < m; k++) {
+        const Customer& c = data.customers[customers[k]];
+        double start = std::max(d[data.depot_index][customers[k]], c.ready);
+        if (start <= c.due) finish[((size_t)1 << k) * m + k] = start + c.service;
+    }
+    for (int mask = 1; mask < full; mask++) {
+        for (int k = 0; k < m; k++) {
+            double time = finish[(size_t)mask * m + k];
+            if (time == INF) continue;
+            bool dead = false;
+            for (int j = 0; j < m && !dead; j++)
+                if (!(mask >> j & 1) && time + d[customers[k]][customers[j]] > data.customers[customers[j]].due) dead = true;
+            if (dead) continue;
+            for (int j = 0; j < m; j++) {
+                if (mask >> j & 1) continue;
+                const Customer& c = data.customers[customers[j]];
+                double next = std::max(time + d[customers[k]][customers[j]], c.ready) + c.service;
+                size_t state = (size_t)(mask | 1 << j) * m + j;
+                if (next < finish[state]) {
+                    finish[state] = next;
+                    parent[state] = k;
+                }
+            }
+        }
+    }
+
+    const Customer& depot = data.customers[data.depot_index];
+    int last = -1;
+    double best = INF;
+    for (int k = 0; k < m; k++) {
+        double back = finish[(size_t)full * m + k] + d[customers[k]][data.depot_index];
+        if (back <= depot.due && back < best) {
+            best = back;
+            last = k;
+        }
+    }
+    std::vector<int> order;
+    for (int mask = full; last >= 0;) {
+        order.push_back(customers[last]);
+        int prev = parent[(size_t)mask * m + last];
+        mask ^= 1 << last;
+        last = prev;
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Optimal orders already found, keyed by the hash of the customer set. Shared by
+// all threads; the sorted set is kept to rule out hash collisions.
+class ExactRouteCache {
+public:
+    bool find(uint64_t key, const std::vector<int>& sorted, std::vector<int>& order) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.sorted != sorted) return false;
+        order = it->second.order;
+        return true;
+    }
+
+    void store(uint64_t key, const std::vector<int>& sorted, const std::vector<int>& order) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key] = { sorted, order };
+    }
+
+private:
+    struct Entry {
+        std::vector<int> sorted, order;
+    };
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+};
+
+// Replaces every route with 3..EXACT_MAX_CUSTOMERS customers by its optimal order.
+// Only sequences change, the caller refreshes costs. Returns the number of improved routes.
+template <class Distance>
+int optimize_short_routes(const ProblemData<Distance>& data, std::vector<Route>& routes, ExactRouteCache& cache, int threads) {
+    std::vector<int> candidates;
+    for (int r = 0; r < (int)routes.size(); r++) {
+        int size = routes[r].sequence.size();
+        if (size >= 3 && size <= EXACT_MAX_CUSTOMERS) candidates.push_back(r);
+    }
+    std::atomic<int> improved{ 0 };
+    parallel_for(threads, candidates.size(), [&](int k) {
+        std::vector<int>& sequence = routes[candidates[k]].sequence;
+        std::vector<int> sorted = sequence;
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t key = customer_set_hash(sorted);
+        std::vector<int> order;
+        if (!cache.find(key, sorted, order)) {
+            order = optimal_route_order(data, sorted);
+            cache.store(key, sorted, order);
+        }
+        if (order.empty() || order == sequence) return;
+        auto current = route_feasible_and_cost(data.customers, data.depot_index, data.distance, sequence);
+        auto optimal = route_feasible_and_cost(data.customers, data.depot_index, data.distance, order);
+        if (!current.first || optimal.second < current.second - 1e-9) {
+            sequence = order;
+            improved++;
+        }
+    });
+    return improved;
+}
+
+// --- PULA TRAS ---
+
+// Feasible routes met during the search, one per customer set (the cheapest order
+// seen). Bounded: when full, the quarter with the worst cost per customer is dropped.
+// All methods are thread-safe so every island can feed the same pool.
+class RoutePool {
+public:
+    struct Entry {
+        std::vector<int> sequence;
+        double cost = 0.0;
+        uint64_t set_hash = 0, sequence_hash = 0;
+    };
+
+    explicit RoutePool(size_t max_routes = 20000) : max_routes(max_routes) {}
+
+    void add(int depot_index, const std::vector<int>& sequence, double cost) {
+        if (sequence.empty()) return;
+        uint64_t set_hash = customer_set_hash(sequence);
+        uint64_t sequence_hash = route_hash(depot_index, sequence);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = by_set.find(set_hash);
+        if (it != by_set.end()) {
+            Entry& known = entries[it->second];
+            if (known.sequence_hash != sequence_hash && cost < known.cost - 1e-9) {
+                known.sequence = sequence;
+                known.cost = cost;
+                known.sequence_hash = sequence_hash;
+            }
+            return;
+        }
+        by_set[set_hash] = entries.size();
+        entries.push_back({ sequence, cost, set_hash, sequence_hash });
+        if (entries.size() > max_routes) shrink();
+    }
+
+    // feasible routes of a solution; in penalty mode the others are skipped
+    template <class Distance>
+    void add_solution(const ProblemData<Distance>& data, const std::vector<Route>& routes) {
+        for (auto& r : routes)
+            if (r.time_warp <= TIME_EPS && r.load <= data.capacity) add(data.depot_index, r.sequence, r.cost - r.penalty);
+    }
+
+    std::vector<Entry> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+private:
+    void shrink() {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.cost * b.sequence.size() < b.cost * a.sequence.size();
+        });
+        entries.resize(max_routes * 3 / 4);
+        by_set.clear();
+        for (size_t k = 0; k < entries.size(); k++) by_set[entries[k].set_hash] = k;
+    }
+
+    size_t max_routes;
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, size_t> by_set;
+};
+
+// Improves a partition with pool routes: a pool route is added when its cost is lower
+// than what removing its customers from their current routes saves. Removing customers
+// keeps a route feasible since distances obey the triangle inequality (checked anyway).
+template <class Distance>
+void improve_partition(const ProblemData<Distance>& data, const std::vector<RoutePool::Entry>& entries,
+    std::vector<std::vector<int>>& routes, std::vector<double>& route_cost) {
+    std::vector<int> owner(data.customers.size(), -1);
+    for (size_t r = 0; r < routes.size(); r++)
+        for (int c : routes[r]) owner[c] = r;
+    bool improved = true;
+    for (int pass = 0; pass < 5 && improved; pass++) {
+        improved = false;
+        for (auto& e : entries) {
+            std::vector<int> affected;
+            for (int c : e.sequence)
+                if (std::find(affected.begin(), affected.end(), owner[c]) == affected.end()) affected.push_back(owner[c]);
+            if (affected.size() == 1 && routes[affected[0]].size() == e.sequence.size()) {
+                if (e.cost >= route_cost[affected[0]] - 1e-6) continue;
+            }
+            double delta = e.cost;
+            std::vector<std::vector<int>> reduced(affected.size());
+            std::vector<double> reduced_cost(affected.size(), 0.0);
+            bool feasible = true;
+            for (size_t a = 0; a < affected.size() && feasible; a++) {
+                for (int c : routes[affected[a]])
+                    if (std::find(e.sequence.begin(), e.sequence.end(), c) == e.sequence.end()) reduced[a].push_back(c);
+                if (!reduced[a].empty()) {
+                    auto fc = route_feasible_and_cost(data.customers, data.depot_index, data.distance, reduced[a]);
+                    feasible = fc.first;
+                    reduced_cost[a] = fc.second;
+                }
+                delta += reduced_cost[a] - route_cost[affected[a]];
+            }
+            if (!feasible || delta >= -1e-6) continue;
+            for (size_t a = 0; a < affected.size(); a++) {
+                routes[affected[a]] = reduced[a];
+                route_cost[affected[a]] = reduced_cost[a];
+            }
+            for (int c : e.sequence) owner[c] = routes.size();
+            routes.push_back(e.sequence);
+            route_cost.push_back(e.cost);
+            improved = true;
+        }
+    }
+}
+
+// Set-partitioning recombination of the pool. The first trial starts from the current
+// solution, the others from a randomized greedy set cover (lazy re-scoring of cost per
+// newly covered customer) where customers covered twice are kept only in the route
+// whose removal saves least. Every trial is finished by improve_partition. Replaces
+// solution when the best trial is cheaper.
+template <class Distance>
+bool recombine_pool(const ProblemData<Distance>& data, const RoutePool& pool, std::vector<Route>& solution,
+    double& cost, std::mt19937& rng, int trials = 10) {
+    std::vector<RoutePool::Entry> entries = pool.snapshot();
+    std::sort(entries.begin(), entries.end(), [](const RoutePool::Entry& a, const RoutePool::Entry& b) {
+        return a.cost * b.sequence.size() < b.cost * a.sequence.size();
+    });
+    int n = data.customers.size();
+    std::vector<int> in_pool(n, 0);
+    for (auto& e : entries)
+        for (int c : e.sequence) in_pool[c] = 1;
+    int to_cover = 0;
+    for (int c = 0; c < n; c++) {
+        if (c == data.depot_index) continue;
+        if (!in_pool[c]) return false;
+        to_cover++;
+    }
+
+    std::uniform_real_distribution<double> noise(1.0, 1.2);
+    std::vector<std::vector<int>> best_routes;
+    double best_total = cost - 1e-6;
+    for (int t = 0; t < trials; t++) {
+        std::vector<std::vector<int>> routes;
+        std::vector<double> route_cost;
+        if (t == 0) {
+            for (auto& r : solution) {
+                if (r.sequence.empty()) continue;
+                routes.push_back(r.sequence);
+                route_cost.push_back(route_feasible_and_cost(data.customers, data.depot_index, data.distance, r.sequence).second);
+            }
+        }
+        else {
+            std::vector<double> weight(entries.size());
+            using Scored = std::pair<double, int>;
+            std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> heap;
+            for (int k = 0; k < (int)entries.size(); k++) {
+                weight[k] = entries[k].cost * noise(rng);
+                heap.push({ weight[k] / entries[k].sequence.size(), k });
+            }
+            std::vector<int> covered(n, 0);
+            int uncovered = to_cover;
+            while (uncovered > 0 && !heap.empty()) {
+                Scored top = heap.top();
+                heap.pop();
+                int fresh = 0;
+                for (int c : entries[top.second].sequence) fresh += !covered[c];
+                if (fresh == 0) continue;
+                double score = weight[top.second] / fresh;
+                if (!heap.empty() && score > heap.top().first + 1e-12) {
+                    heap.push({ score, top.second });
+                    continue;
+                }
+                routes.push_back(entries[top.second].sequence);
+                route_cost.push_back(entries[top.second].cost);
+                for (int c : entries[top.second].sequence) uncovered -= !covered[c]++;
+            }
+
+            // customers covered more than once stay in the route where removal saves least
+            std::vector<std::vector<int>> holders(n);
+            for (size_t r = 0; r < routes.size(); r++)
+                for (int c : routes[r]) if (covered[c] > 1) holders[c].push_back(r);
+            bool broken = false;
+            for (int c = 0; c < n && !broken; c++) {
+                if (holders[c].size() < 2) continue;
+                std::vector<std::pair<double, int>> savings;
+                for (int r : holders[c]) {
+                    std::vector<int> reduced = routes[r];
+                    reduced.erase(std::find(reduced.begin(), reduced.end(), c));
+                    auto fc = route_feasible_and_cost(data.customers, data.depot_index, data.distance, reduced);
+                    savings.push_back({ fc.first ? route_cost[r] - (reduced.empty() ? 0.0 : fc.second) : -1.0, r });
+                }
+                std::sort(savings.begin(), savings.end());
+                for (size_t k = 1; k < savings.size(); k++) {
+                    int r = savings[k].second;
+                    if (savings[k].first < 0.0) broken = true;
+                    routes[r].erase(std::find(routes[r].begin(), routes[r].end(), c));
+                    route_cost[r] -= savings[k].first;
+                }
+            }
+            if (broken) continue;
+        }
+        improve_partition(data, entries, routes, route_cost);
+        double total = 0.0;
+        for (size_t r = 0; r < routes.size(); r++) if (!routes[r].empty()) total += route_cost[r];
+        if (total < best_total) {
+            best_total = total;
+            best_routes = std::move(routes);
+        }
+    }
+    if (best_routes.empty()) return false;
+
+    solution.clear();
+    for (auto& sequence : best_routes) {
+        if (sequence.empty()) continue;
+        Route r;
+        r.sequence = sequence;
+        for (int c : sequence) r.load += data.customers[c].demand;
+        r.cost = route_feasible_and_cost(data.customers, data.depot_index, data.distance, sequence).second;
+        solution.push_back(r);
+    }
+    cost = best_total;
+    return true;
+}
+
+// --- PUNKTY KONTROLNE ---
+
+// written to path.tmp and renamed, so a reader or a crash never sees a half-written file
+void replace_file(const std::string& path, const std::string& content) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc | std::ios::binary);
+        out << content;
+        out.flush();
+        if (!out) throw std::runtime_error("Cannot write " + temporary + ".");
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        // Windows does not replace an existing file on rename
+        std::remove(path.c_str());
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) throw std::runtime_error("Cannot replace " + path + ".");
+    }
+}
+
+// Everything a single tabu trajectory needs to continue exactly where it stopped.
+// The move store is not saved: the search rebuilds it right after a checkpoint, in
+// the original run and in the resumed one alike.
+struct TabuCheckpoint {
+    uint64_t instance_hash = 0;
+    double elapsed = 0.0;               // seconds of the run when written
+    std::vector<std::vector<int>> best, current;
+    double best_cost = 0.0;
+    TabuList tabu;
+    VisitedSet visited;
+    std::string rng_state;
+    double tenure = 0.0, average_cycle = 0.0;
+    long long last_tenure_change = 0;
+    int often_repeated = 0;
+    double time_warp_weight = 0.0, capacity_weight = 0.0;
+    int time_feasible_count = 0, load_feasible_count = 0;
+    double act_cost = 0.0, previous_cost = 0.0, reported_cost = 0.0;
+    int repeat_counter = 0, restarts_without_gain = 0;
+    long long iterations = 0;
+    int restarts = 0, escapes = 0, recombinations = 0;
+    std::vector<RoutePool::Entry> pool;
+
+    void write(std::ostream& out) const {
+        out << std::setprecision(17);
+        auto write_routes = [&](const char* name, const std::vector<std::vector<int>>& routes) {
+            out << name << " " << routes.size() << "\n";
+            for (auto& r : routes) {
+                out << r.size();
+                for (int c : r) out << " " << c;
+                out << "\n";
+            }
+        };
+        out << "cvrptw-checkpoint 2\n";
+        out << "instance " << instance_hash << "\nelapsed " << elapsed << "\n";
+        write_routes("best", best);
+        write_routes("current", current);
+        out << "best_cost " << best_cost << "\n";
+        out << "tabu " << tabu.attributes().size() << "\n";
+        for (auto& a : tabu.attributes())
+            out << a.customer << " " << a.route << " " << a.iteration << "\n";
+        visited.write(out);
+        out << "rng " << rng_state << "\n";
+        out << "reactive " << tenure << " " << average_cycle << " " << last_tenure_change << " " << often_repeated << "\n";
+        out << "penalty " << time_warp_weight << " " << capacity_weight << " " << time_feasible_count << " " << load_feasible_count << "\n";
+        out << "costs " << act_cost << " " << previous_cost << " " << reported_cost << " " << repeat_counter << " " << restarts_without_gain << "\n";
+        out << "counters " << iterations << " " << restarts << " " << escapes << " " << recombinations << "\n";
+        out << "pool " << pool.size() << "\n";
+        for (auto& e : pool) {
+            out << e.cost << " " << e.sequence.size();
+            for (int c : e.sequence) out << " " << c;
+            out << "\n";
+        }
+        out << "end\n";
+    }
+
+    // throws std::runtime_error on a malformed or truncated file
+    static TabuCheckpoint read(std::istream& in) {
+        TabuCheckpoint cp;
+        std::string label;
+        auto expect = [&](const char* name) {
+            if (!(in >> label) || label != name) throw std::runtime_error(std::string("Bad checkpoint, expected ") + name + ".");
+        };
+        auto read_routes = [&](const char* name, std::vector<std::vector<int>>& routes) {
+            expect(name);
+            size_t count, len;
+            in >> count;
+            routes.resize(count);
+            for (auto& r : routes) {
+                in >> len;
+                r.resize(len);
+                for (int& c : r) in >> c;
+            }
+        };
+        int version;
+        expect("cvrptw-checkpoint");
+        in >> version;
+        if (version != 2) throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version) + ".");
+        expect("instance");
+        in >> cp.instance_hash;
+        expect("elapsed");
+        in >> cp.elapsed;
+        read_routes("best", cp.best);
+        read_routes("current", cp.current);
+        expect("best_cost");
+        in >> cp.best_cost;
+        expect("tabu");
+        size_t count;
+        in >> count;
+        for (size_t k = 0; k < count; k++) {
+            TabuList::Attribute a;
+            in >> a.customer >> a.route >> a.iteration;
+            cp.tabu.add(a.customer, a.route, a.iteration);
+        }
+        cp.visited.read(in);
+        expect("rng");
+        std::getline(in >> std::ws, cp.rng_state);
+        expect("reactive");
+        in >> cp.tenure >> cp.average_cycle >> cp.last_tenure_change >> cp.often_repeated;
+        expect("penalty");
+        in >> cp.time_warp_weight >> cp.capacity_weight >> cp.time_feasible_count >> cp.load_feasible_count;
+        expect("costs");
+        in >> cp.act_cost >> cp.previous_cost >> cp.reported_cost >> cp.repeat_counter >> cp.restarts_without_gain;
+        expect("counters");
+        in >> cp.iterations >> cp.restarts >> cp.escapes >> cp.recombinations;
+        expect("pool");
+        in >> count;
+        cp.pool.resize(count);
+        for (auto& e : cp.pool) {
+            size_t len;
+            in >> e.cost >> len;
+            e.sequence.resize(len);
+            for (int& c : e.sequence) in >> c;
+        }
+        expect("end");
+        return cp;
+    }
+
+    void save(const std::string& path) const {
+        std::ostringstream out;
+        write(out);
+        replace_file(path, out.str());
+    }
+
+    static TabuCheckpoint load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open checkpoint " + path + ".");
+        return read(in);
+    }
+};
+
+// called with every new best solution of a search; island threads call it concurrently
+using ImprovementCallback = std::function<void(const std::vector<Route>& routes, double cost, long long iteration)>;
+
+// zmienne do kontrolowania tabu search
+struct TabuParams {
+    int tenure = 30;
+    // reactive tenure: bounds, growth on revisits, shrink after a stable stretch
+    int min_tenure = 5, max_tenure = 500;
+    double tenure_increase = 1.2, tenure_decrease = 0.9;
+    int stable_period = 100;
+    // escape after this many solutions were each visited at least repeat_visits times
+    int repeat_visits = 3, chaotic_limit = 3;
+    // infeasible-space search: penalties adapt every penalty_period iterations towards
+    // the target share of iterations spent feasible in each constraint
+    bool penalty_mode = false;
+    int penalty_period = 10;
+    double feasible_target = 0.3;
+    // feasible improvements are rarer when most iterations are infeasible
+    int penalty_max_repeat = 300;
+    int max_repeat = 50;
+    int cross_max_len = 3;
+    // island mode only: exchange period, restarts allowed without improving the global best
+    int exchange_every = 100;
+    int max_restarts = 10;
+    double divergence = 0.05;
+    // intensification: exact re-optimization of short routes every exact_every iterations
+    ExactRouteCache* exact_cache = nullptr;
+    int exact_every = 50;
+    // route pool fed with every changed route, recombined every pool_every iterations
+    RoutePool* pool = nullptr;
+    int pool_every = 500;
+    // stop as soon as the best cost reaches this value (lower bound + allowed gap)
+    double target_cost = 0.0;
+    ImprovementCallback on_improvement;
+    // online mode: asked every iteration for customers that arrived meanwhile, inserts
+    // them into the routes and returns true when it did. Where the search would stop
+    // because it stalled, it is asked with idle = true and may wait; false ends the search.
+    std::function<bool(std::vector<Route>& routes, bool idle)> arrivals;
+    // single trajectory only: periodic checkpoints and the state to resume from
+    std::string checkpoint_path;
+    double checkpoint_every = 30.0;
+    uint64_t instance_hash = 0;
+    double elapsed_before = 0.0;        // run time already spent, kept in checkpoints
+    const TabuCheckpoint* resume = nullptr;
+    unsigned seed = 0;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+struct TabuResult {
+    std::vector<Route> best_solution;
+    double best_cost = 0.0;
+    long long iterations = 0;
+    int restarts = 0;
+    int escapes = 0;
+    int recombinations = 0;
+    int final_tenure = 0;
+    // per-island and per-operator summaries for the caller to report
+    std::vector<std::string> notes;
+};
+
+// One tabu search trajectory. With a shared slot (island mode) the best solution is
+// published every exchange_every iterations, and instead of stopping on stagnation
+// or after drifting too far from the global best the search restarts from it.
+template <class Distance>
+TabuResult tabu_search(const ProblemData<Distance>& data, const std::vector<Route>& start, const TabuParams& params,
+    IncumbentSlot* shared = nullptr, int island = 0) {
+    constexpr int MAX_SCAN = 1000;
+    constexpr double REPEAT_EPS = 1e-6;
+
+    std::mt19937 rng(params.seed);
+    TabuList tabu;
+    SearchState state;
+    state.routes = start;
+    state.penalty.enabled = params.penalty_mode;
+    refresh_all_routes(data, state);
+    MoveStore store(MAX_SCAN);
+    int time_feasible_count = 0, load_feasible_count = 0;
+
+    // reactive tabu: solution hashes and a tenure reacting to revisits
+    VisitedSet visited;
+    uint64_t current_hash = solution_hash(state.routes);
+    double tenure = params.tenure;
+    long long last_tenure_change = 0;
+    double average_cycle = 0.0;
+    int often_repeated = 0;
+    bool rebuild_store = true;
+    bool just_rebuilt = false;
+
+    TabuResult result;
+    result.best_solution = state.routes;
+    result.best_cost = 0.0;
+    for (auto& r : state.routes) result.best_cost += r.cost;
+    std::vector<Route>& best_solution = result.best_solution;
+    double& best_cost = result.best_cost;
+
+    // zmienne do kontrolowania powtórzeń
+    double act_cost = best_cost;
+    int repeat_counter = 0;
+    double previous_cost = act_cost;
+    double reported_cost = best_cost;
+    int restarts_without_gain = 0;
+
+    auto to_routes = [&](const std::vector<std::vector<int>>& sequences) {
+        std::vector<Route> routes(sequences.size());
+        for (size_t r = 0; r < sequences.size(); r++) {
+            routes[r].sequence = sequences[r];
+            for (int c : sequences[r]) routes[r].load += data.customers[c].demand;
+            routes[r].cost = route_feasible_and_cost(data.customers, data.depot_index, data.distance, sequences[r]).second;
+        }
+        return routes;
+    };
+    auto to_sequences = [](const std::vector<Route>& routes) {
+        std::vector<std::vector<int>> sequences;
+        for (auto& r : routes) sequences.push_back(r.sequence);
+        return sequences;
+    };
+    if (params.resume) {
+        const TabuCheckpoint& cp = *params.resume;
+        state.routes = to_routes(cp.current);
+        best_solution = to_routes(cp.best);
+        best_cost = cp.best_cost;
+        tabu = cp.tabu;
+        visited = cp.visited;
+        std::istringstream(cp.rng_state) >> rng;
+        tenure = cp.tenure;
+        average_cycle = cp.average_cycle;
+        last_tenure_change = cp.last_tenure_change;
+        often_repeated = cp.often_repeated;
+        state.penalty.time_warp = cp.time_warp_weight;
+        state.penalty.capacity = cp.capacity_weight;
+        time_feasible_count = cp.time_feasible_count;
+        load_feasible_count = cp.load_feasible_count;
+        act_cost = cp.act_cost;
+        previous_cost = cp.previous_cost;
+        reported_cost = cp.reported_cost;
+        repeat_counter = cp.repeat_counter;
+        restarts_without_gain = cp.restarts_without_gain;
+        result.iterations = cp.iterations;
+        result.restarts = cp.restarts;
+        result.escapes = cp.escapes;
+        result.recombinations = cp.recombinations;
+        refresh_all_routes(data, state);
+        current_hash = solution_hash(state.routes);
+    }
+    // routes changed by params.arrivals: the best solution so far misses the new
+    // customers, so the search goes on from the changed routes as the new best
+    auto take_arrivals = [&]() {
+        tabu.clear();
+        visited.clear();
+        refresh_all_routes(data, state);
+        current_hash = solution_hash(state.routes);
+        rebuild_store = true;
+        best_solution = state.routes;
+        best_cost = 0.0;
+        for (auto& r : state.routes) best_cost += r.cost;
+        act_cost = previous_cost = reported_cost = best_cost;
+        repeat_counter = 0;
+    };
+    auto run_start = std::chrono::steady_clock::now();
+    auto checkpoint_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(params.checkpoint_every));
+    auto next_checkpoint = run_start + checkpoint_period;
+
+    while (best_cost > params.target_cost && std::chrono::steady_clock::now() < params.deadline) {
+        if (params.arrivals && params.arrivals(state.routes, false)) take_arrivals();
+        std::vector<Route>& actual_solution = state.routes;
+        int route_count = actual_solution.size();
+
+        if (!params.checkpoint_path.empty() && !shared && std::chrono::steady_clock::now() >= next_checkpoint) {
+            TabuCheckpoint cp;
+            cp.instance_hash = params.instance_hash;
+            cp.elapsed = params.elapsed_before + std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+            cp.best = to_sequences(best_solution);
+            cp.current = to_sequences(actual_solution);
+            cp.best_cost = best_cost;
+            cp.tabu = tabu;
+            cp.visited = visited;
+            std::ostringstream rng_state;
+            rng_state << rng;
+            cp.rng_state = rng_state.str();
+            cp.tenure = tenure;
+            cp.average_cycle = average_cycle;
+            cp.last_tenure_change = last_tenure_change;
+            cp.often_repeated = often_repeated;
+            cp.time_warp_weight = state.penalty.time_warp;
+            cp.capacity_weight = state.penalty.capacity;
+            cp.time_feasible_count = time_feasible_count;
+            cp.load_feasible_count = load_feasible_count;
+            cp.act_cost = act_cost;
+            cp.previous_cost = previous_cost;
+            cp.reported_cost = reported_cost;
+            cp.repeat_counter = repeat_counter;
+            cp.restarts_without_gain = restarts_without_gain;
+            cp.iterations = result.iterations;
+            cp.restarts = result.restarts;
+            cp.escapes = result.escapes;
+            cp.recombinations = result.recombinations;
+            if (params.pool) cp.pool = params.pool->snapshot();
+            cp.save(params.checkpoint_path);
+            // route costs as a resumed run recomputes them
+            refresh_all_routes(data, state);
+            next_checkpoint = std::chrono::steady_clock::now() + checkpoint_period;
+            // a resumed run starts with a fresh store, so this one does too
+            rebuild_store = true;
+        }
+
+        // full evaluation only at the start and after the number of routes changed
+        if (rebuild_store) {
+            refresh_all_routes(data, state);
+            store.reset(route_count);
+            for (int route1 = 0; route1 < route_count; route1++)
+                for (int route2 = route1 + 1; route2 < route_count; route2++)
+                    store.set_pair(route1, route2, evaluate_route_pair(data, state, route1, route2, params.cross_max_len, store.cutoff()));
+            rebuild_store = false;
+            just_rebuilt = true;
+        }
+        else {
+            just_rebuilt = false;
+        }
+
+        // a move is tabu when it brings a customer back into a route it recently left,
+        // unless it leads to a new best solution (aspiration)
+        double current_cost = 0.0;
+        for (auto& r : actual_solution) current_cost += r.cost;
+        auto is_tabu = [&](const Move& m) {
+            if (current_cost + m.cost < best_cost - REPEAT_EPS) return false;
+            int len1, len2;
+            move_lengths(m, len1, len2);
+            for (int k = 0; k < len1; k++)
+                if (tabu.forbidden(actual_solution[m.route1].sequence[m.a + k], m.route2)) return true;
+            for (int k = 0; k < len2; k++)
+                if (tabu.forbidden(actual_solution[m.route2].sequence[m.b + k], m.route1)) return true;
+            return false;
+        };
+
+        // chosing the best move 
+        // (best non-tabu move among the MAX_SCAN best ones, otherwise the best one)
+        std::vector<MoveStore::Entry> skipped;
+        MoveStore::Entry entry;
+        Move chosen;
+        bool found = false;
+        while ((int)skipped.size() < MAX_SCAN && store.pop_best(entry)) {
+            const Move& candidate = store.move(entry);
+            if (!is_tabu(candidate)) {
+                found = true;
+                chosen = candidate;
+                break;
+            }
+            skipped.push_back(entry);
+        }
+        // gdy nie ma ruchow z poza tabu
+        if (!found) {
+            if (skipped.empty()) {
+                // moves may have been dropped by an outdated cutoff, evaluate everything again
+                if (!just_rebuilt) {
+                    rebuild_store = true;
+                    continue;
+                }
+                if (!params.arrivals || !params.arrivals(state.routes, true)) break;
+                take_arrivals();
+                continue;
+            }
+            chosen = store.move(skipped[0]);
+        }
+        for (auto& e : skipped) store.push(e);
+        {
+            int len1, len2;
+            move_lengths(chosen, len1, len2);
+            const std::vector<int>& seq1 = actual_solution[chosen.route1].sequence;
+            const std::vector<int>& seq2 = actual_solution[chosen.route2].sequence;
+            for (int k = 0; k < len1; k++) tabu.add(seq1[chosen.a + k], chosen.route1, result.iterations);
+            for (int k = 0; k < len2; k++) tabu.add(seq2[chosen.b + k], chosen.route2, result.iterations);
+            // a whole route moving over swaps the meaning of the two labels, so the
+            // customers left behind in the other route count as having left it too
+            if (len1 == (int)seq1.size())
+                for (int k = 0; k < (int)seq2.size(); k++)
+                    if (k < chosen.b || k >= chosen.b + len2) tabu.add(seq2[k], chosen.route1, result.iterations);
+            if (len2 == (int)seq2.size())
+                for (int k = 0; k < (int)seq1.size(); k++)
+                    if (k < chosen.a || k >= chosen.a + len1) tabu.add(seq1[k], chosen.route2, result.iterations);
+        }
+
+        // creating actual solution
+        apply_move(actual_solution, data.customers, chosen);
+        result.iterations++;
+        tabu.expire(result.iterations, tenure);
+
+        if (actual_solution[chosen.route1].sequence.empty() || actual_solution[chosen.route2].sequence.empty()) {
+            // the attributes follow the routes to their new indices
+            std::vector<int> new_index(route_count, -1);
+            for (int r = 0, next = 0; r < route_count; r++)
+                if (!actual_solution[r].sequence.empty()) new_index[r] = next++;
+            tabu.renumber(new_index);
+            remove_empty_routes(actual_solution);
+            rebuild_store = true;
+            refresh_all_routes(data, state);
+            current_hash = solution_hash(actual_solution);
+            if (params.pool) params.pool->add_solution(data, actual_solution);
+        }
+        else {
+            // only pairs with one of the two modified routes need new moves
+            current_hash ^= actual_solution[chosen.route1].hash ^ actual_solution[chosen.route2].hash;
+            refresh_route(data, state, chosen.route1);
+            refresh_route(data, state, chosen.route2);
+            current_hash ^= actual_solution[chosen.route1].hash ^ actual_solution[chosen.route2].hash;
+            store.touch(chosen.route1);
+            store.touch(chosen.route2);
+            if (params.pool) {
+                for (int touched : { chosen.route1, chosen.route2 }) {
+                    const Route& r = actual_solution[touched];
+                    if (r.time_warp <= TIME_EPS && r.load <= data.capacity) params.pool->add(data.depot_index, r.sequence, r.cost - r.penalty);
+                }
+            }
+            for (int other = 0; other < route_count; other++) {
+                for (int touched : { chosen.route1, chosen.route2 }) {
+                    if (other == touched || (other == chosen.route1 && touched == chosen.route2)) continue;
+                    int lo = std::min(other, touched), hi = std::max(other, touched);
+                    store.set_pair(lo, hi, evaluate_route_pair(data, state, lo, hi, params.cross_max_len, store.cutoff()));
+                }
+            }
+            store.compact();
+        }
+
+        if (params.exact_cache && result.iterations % params.exact_every == 0
+            && optimize_short_routes(data, actual_solution, *params.exact_cache, 1) > 0) {
+            refresh_all_routes(data, state);
+            current_hash = solution_hash(actual_solution);
+            rebuild_store = true;
+        }
+
+        act_cost = 0.0;
+        for (auto& r : actual_solution) act_cost += r.cost;
+        if (!state.penalty.enabled) {
+            if (act_cost < best_cost) {
+                best_solution = actual_solution;
+                best_cost = act_cost;
+            }
+        }
+        else {
+            // only feasible solutions can become the best one
+            bool time_ok = true, load_ok = true;
+            for (auto& r : actual_solution) {
+                time_ok &= r.time_warp <= TIME_EPS;
+                load_ok &= r.load <= data.capacity;
+            }
+            time_feasible_count += time_ok;
+            load_feasible_count += load_ok;
+            if (time_ok && load_ok && act_cost < best_cost) {
+                best_solution = actual_solution;
+                best_cost = act_cost;
+            }
+            if (result.iterations % params.penalty_period == 0) {
+                auto adapt = [&](double& weight, int feasible_count) {
+                    double share = (double)feasible_count / params.penalty_period;
+                    if (share < params.feasible_target - 0.05) weight = std::min(weight * 1.3, 1e5);
+                    else if (share > params.feasible_target + 0.05) weight = std::max(weight * 0.85, 0.1);
+                };
+                Penalties old_weights = state.penalty;
+                adapt(state.penalty.time_warp, time_feasible_count);
+                adapt(state.penalty.capacity, load_feasible_count);
+                time_feasible_count = load_feasible_count = 0;
+                // route costs and stored deltas follow the new weights
+                refresh_all_routes(data, state);
+                store.rescore(state.penalty.time_warp - old_weights.time_warp, state.penalty.capacity - old_weights.capacity);
+            }
+        }
+
+        // set-partitioning over the pool, continuing from its result when it is better
+        if (params.pool && result.iterations % params.pool_every == 0
+            && recombine_pool(data, *params.pool, best_solution, best_cost, rng)) {
+            state.routes = best_solution;
+            // route indices of the recombined solution mean nothing to the old attributes
+            tabu.clear();
+            refresh_all_routes(data, state);
+            current_hash = solution_hash(state.routes);
+            act_cost = best_cost;
+            rebuild_store = true;
+            result.recombinations++;
+        }
+        if (best_cost < reported_cost) {
+            reported_cost = best_cost;
+            if (params.on_improvement) params.on_improvement(best_solution, best_cost, result.iterations);
+        }
+
+        // reactive tenure: grow on a revisit, shrink when no revisit for a while
+        VisitedSet::Visit visit = visited.record(current_hash, result.iterations);
+        if (visit.last >= 0) {
+            double cycle = (double)(result.iterations - visit.last);
+            average_cycle = average_cycle > 0.0 ? 0.9 * average_cycle + 0.1 * cycle : cycle;
+            tenure = std::min<double>(params.max_tenure, tenure * params.tenure_increase + 1.0);
+            last_tenure_change = result.iterations;
+            if (visit.count == params.repeat_visits) often_repeated++;
+        }
+        else if (result.iterations - last_tenure_change > params.stable_period) {
+            tenure = std::max<double>(params.min_tenure, tenure * params.tenure_decrease);
+            last_tenure_change = result.iterations;
+        }
+        // persistent cycling: escape with random moves and forget the memory
+        if (often_repeated > params.chaotic_limit) {
+            perturb_solution(data, actual_solution, rng, 1 + (int)(average_cycle / 2));
+            tabu.clear();
+            visited.clear();
+            often_repeated = 0;
+            rebuild_store = true;
+            refresh_all_routes(data, state);
+            current_hash = solution_hash(actual_solution);
+            result.escapes++;
+        }
+
+        bool restart = false;
+        if (std::fabs(previous_cost - best_cost) < REPEAT_EPS) {
+            repeat_counter++;
+            if (repeat_counter >= (state.penalty.enabled ? params.penalty_max_repeat : params.max_repeat)) {
+                if (params.arrivals) {
+                    if (!params.arrivals(state.routes, true)) break;
+                    take_arrivals();
+                    continue;
+                }
+                if (!shared) break;
+                restart = true;
+            }
+        }
+        else {
+            repeat_counter = 0;
+            previous_cost = best_cost;
+        }
+
+        // elite exchange between islands
+        if (shared && (restart || result.iterations % params.exchange_every == 0)) {
+            std::shared_ptr<const Incumbent> global = shared->load();
+            if (best_cost < global->cost - REPEAT_EPS) {
+                shared->publish(best_solution, best_cost, island);
+                restarts_without_gain = 0;
+            }
+            else if (act_cost > global->cost * (1.0 + params.divergence)) {
+                restart = true;
+            }
+        }
+        if (restart) {
+            if (++restarts_without_gain > params.max_restarts) break;
+            std::shared_ptr<const Incumbent> global = shared->load();
+            state.routes = global->routes;
+            perturb_solution(data, state.routes, rng, 1 + data.customers.size() / 50);
+            tabu.clear();
+            visited.clear();
+            refresh_all_routes(data, state);
+            current_hash = solution_hash(state.routes);
+            rebuild_store = true;
+            repeat_counter = 0;
+            result.restarts++;
+        }
+    }
+    if (shared) shared->publish(best_solution, best_cost, island);
+    result.final_tenure = (int)tenure;
+    for (auto& r : best_solution) r.penalty = 0.0;
+    return result;
+}
+
+// Island model: independent tabu trajectories on separate threads, each with its own
+// seed, tenure and perturbed starting solution, exchanging elites through a shared slot.
+template <class Distance>
+TabuResult island_search(const ProblemData<Distance>& data, const std::vector<Route>& start, double start_cost,
+    const TabuParams& params, int islands) {
+    IncumbentSlot shared;
+    shared.publish(start, start_cost, -1);
+    std::vector<TabuResult> results(islands);
+    std::vector<std::thread> threads;
+    for (int k = 0; k < islands; k++) {
+        TabuParams island_params = params;
+        island_params.seed = params.seed + 7919u * k;
+        island_params.tenure = std::max(5, params.tenure / 2 + (k * params.tenure) / islands);
+        threads.emplace_back([&data, &start, &shared, &results, island_params, k]() {
+            std::vector<Route> island_start = start;
+            if (k > 0) {
+                std::mt19937 rng(island_params.seed);
+                perturb_solution(data, island_start, rng, 1 + data.customers.size() / 20);
+            }
+            results[k] = tabu_search(data, island_start, island_params, &shared, k);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    TabuResult total;
+    std::shared_ptr<const Incumbent> best = shared.load();
+    total.best_solution = best->routes;
+    total.best_cost = best->cost;
+    for (int k = 0; k < islands; k++) {
+        total.iterations += results[k].iterations;
+        total.restarts += results[k].restarts;
+        total.escapes += results[k].escapes;
+        total.notes.push_back("island " + std::to_string(k) + ": iterations " + std::to_string(results[k].iterations)
+            + ", restarts " + std::to_string(results[k].restarts) + ", best " + format_cost(results[k].best_cost));
+    }
+    return total;
+}
+
+// Decomposition for large instances: the routes are split into sectors of nearby
+// routes, by centroid angle around the depot or by k-means on the centroids, and
+// every sector is improved by its own tabu search on a worker thread. Sector bounds
+// move each round (random rotation of the angles, new k-means seeds). Stops at the
+// deadline or after rounds_without_gain rounds that improved nothing.
+template <class Distance>
+TabuResult decomposition_search(const ProblemData<Distance>& data, const std::vector<Route>& start,
+    const TabuParams& params, int sectors, int threads, bool kmeans, int rounds_without_gain = 3) {
+    std::mt19937 rng(params.seed);
+    const Customer& depot = data.customers[data.depot_index];
+    TabuResult result;
+    result.best_solution = start;
+    for (auto& r : start) result.best_cost += route_feasible_and_cost(data.customers, data.depot_index, data.distance, r.sequence).second;
+
+    int stale_rounds = 0;
+    for (int round = 0; stale_rounds < rounds_without_gain && result.best_cost > params.target_cost
+        && std::chrono::steady_clock::now() < params.deadline; round++) {
+        const std::vector<Route>& current = result.best_solution;
+        int route_count = current.size();
+        int parts = std::max(1, std::min(sectors, route_count / 4));
+        std::vector<double> cx(route_count, 0.0), cy(route_count, 0.0);
+        for (int r = 0; r < route_count; r++) {
+            for (int c : current[r].sequence) {
+                cx[r] += data.customers[c].x;
+                cy[r] += data.customers[c].y;
+            }
+            cx[r] /= std::max<size_t>(1, current[r].sequence.size());
+            cy[r] /= std::max<size_t>(1, current[r].sequence.size());
+        }
+
+        std::vector<std::vector<int>> sector_routes(parts);
+        if (!kmeans) {
+            std::vector<int> order(route_count);
+            std::vector<double> angle(route_count);
+            for (int r = 0; r < route_count; r++) {
+                order[r] = r;
+                angle[r] = std::atan2(cy[r] - depot.y, cx[r] - depot.x);
+            }
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return angle[a] < angle[b]; });
+            int offset = rng() % route_count;
+            for (int k = 0; k < route_count; k++)
+                sector_routes[(long long)k * parts / route_count].push_back(order[(offset + k) % route_count]);
+        }
+        else {
+            std::vector<double> mx(parts), my(parts);
+            std::vector<int> seeds(route_count), assigned(route_count, 0);
+            for (int r = 0; r < route_count; r++) seeds[r] = r;
+            std::shuffle(seeds.begin(), seeds.end(), rng);
+            for (int k = 0; k < parts; k++) {
+                mx[k] = cx[seeds[k]];
+                my[k] = cy[seeds[k]];
+            }
+            for (int it = 0; it < 10; it++) {
+                std::vector<double> sx(parts, 0.0), sy(parts, 0.0);
+                std::vector<int> count(parts, 0);
+                for (int r = 0; r < route_count; r++) {
+                    double best = std::numeric_limits<double>::infinity();
+                    for (int k = 0; k < parts; k++) {
+                        double dist = (cx[r] - mx[k]) * (cx[r] - mx[k]) + (cy[r] - my[k]) * (cy[r] - my[k]);
+                        if (dist < best) {
+                            best = dist;
+                            assigned[r] = k;
+                        }
+                    }
+                    sx[assigned[r]] += cx[r];
+                    sy[assigned[r]] += cy[r];
+                    count[assigned[r]]++;
+                }
+                for (int k = 0; k < parts; k++) {
+                    if (!count[k]) continue;
+                    mx[k] = sx[k] / count[k];
+                    my[k] = sy[k] / count[k];
+                }
+            }
+            for (int r = 0; r < route_count; r++) sector_routes[assigned[r]].push_back(r);
+        }
+
+        std::vector<TabuResult> sector_results(parts);
+        parallel_for(threads, parts, [&](int k) {
+            std::vector<Route> sub;
+            for (int r : sector_routes[k]) sub.push_back(current[r]);
+            if (sub.size() < 2) {
+                sector_results[k].best_solution = sub;
+                for (auto& r : sub) sector_results[k].best_cost += route_feasible_and_cost(data.customers, data.depot_index, data.distance, r.sequence).second;
+                return;
+            }
+            TabuParams sector_params = params;
+            sector_params.seed = params.seed + 7919u * round + 131u * k;
+            // the pool recombines and callers expect complete solutions only
+            sector_params.pool = nullptr;
+            sector_params.on_improvement = nullptr;
+            // the target bounds the whole solution; a sector is never compared against it,
+            // the round loop checks the merged cost instead
+            sector_params.target_cost = 0.0;
+            // sectors run concurrently, they must not share one checkpoint file
+            sector_params.checkpoint_path.clear();
+            sector_params.resume = nullptr;
+            sector_results[k] = tabu_search(data, sub, sector_params);
+        });
+
+        std::vector<Route> merged;
+        double merged_cost = 0.0;
+        for (auto& sr : sector_results) {
+            merged.insert(merged.end(), sr.best_solution.begin(), sr.best_solution.end());
+            merged_cost += sr.best_cost;
+            result.iterations += sr.iterations;
+            result.escapes += sr.escapes;
+        }
+        remove_empty_routes(merged);
+        if (params.pool) params.pool->add_solution(data, merged);
+        if (merged_cost < result.best_cost - 1e-6) {
+            result.best_solution = std::move(merged);
+            result.best_cost = merged_cost;
+            stale_rounds = 0;
+            if (params.on_improvement) params.on_improvement(result.best_solution, result.best_cost, result.iterations);
+        }
+        else stale_rounds++;
+        result.restarts++;
+    }
+    return result;
+}
+
+// --- ALNS ---
+
+// removes the given customers from their routes and drops routes that became empty
+template <class Distance>
+void remove_customers(const ProblemData<Distance>& data, SearchState& state, const std::vector<int>& removed) {
+    std::vector<char> is_removed(data.customers.size(), 0);
+    for (int c : removed) is_removed[c] = 1;
+    for (auto& route : state.routes) {
+        std::vector<int> kept;
+        kept.reserve(route.sequence.size());
+        for (int c : route.sequence) {
+            if (is_removed[c]) route.load -= data.customers[c].demand;
+            else kept.push_back(c);
+        }
+        route.sequence = std::move(kept);
+    }
+    remove_empty_routes(state.routes);
+    refresh_all_routes(data, state);
+}
+
+std::vector<int> routed_customers(const SearchState& state) {
+    std::vector<int> all;
+    for (auto& route : state.routes) all.insert(all.end(), route.sequence.begin(), route.sequence.end());
+    return all;
+}
+
+// picks an index from a list sorted best-first, biased towards the front
+int biased_index(std::mt19937& rng, int size, double power) {
+    double y = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    return std::min(size - 1, (int)(std::pow(y, power) * size));
+}
+
+template <class Distance>
+std::vector<int> destroy_random(const ProblemData<Distance>& data, SearchState& state, std::mt19937& rng, int count) {
+    std::vector<int> all = routed_customers(state);
+    std::shuffle(all.begin(), all.end(), rng);
+    all.resize(std::min<int>(count, all.size()));
+    remove_customers(data, state, all);
+    return all;
+}
+
+// removes customers whose removal saves the most
+template <class Distance>
+std::vector<int> destroy_worst(const ProblemData<Distance>& data, SearchState& state, std::mt19937& rng, int count) {
+    std::vector<std::pair<double, int>> gains;
+    for (int r = 0; r < (int)state.routes.size(); r++) {
+        const RouteSegments& rs = state.segments[r];
+        for (int p = 0; p < (int)state.routes[r].sequence.size(); p++) {
+            Segment without = concat_segments(rs.prefix[p], rs.suffix[p + 1], data.distance);
+            gains.push_back({ state.routes[r].cost - segment_cost(without), state.routes[r].sequence[p] });
+        }
+    }
+    std::sort(gains.begin(), gains.end(), [](const std::pair<double, int>& a, const std::pair<double, int>& b) { return a.first > b.first; });
+    std::vector<int> removed;
+    while ((int)removed.size() < count && !gains.empty()) {
+        int k = biased_index(rng, gains.size(), 3.0);
+        removed.push_back(gains[k].second);
+        gains.erase(gains.begin() + k);
+    }
+    remove_customers(data, state, removed);
+    return removed;
+}
+
+// Shaw removal: customers close in space, time and demand to already removed ones
+template <class Distance>
+std::vector<int> destroy_related(const ProblemData<Distance>& data, SearchState& state, std::mt19937& rng, int count) {
+    const CustomerTable& customers = data.customers;
+    std::vector<int> remaining = routed_customers(state);
+    if (remaining.empty()) return remaining;
+    double max_distance = 1e-9, max_time = 1e-9, max_demand = 1e-9;
+    for (int c : remaining) {
+        max_distance = std::max(max_distance, data.distance[data.depot_index][c]);
+        max_time = std::max(max_time, customers[c].ready);
+        max_demand = std::max(max_demand, (double)customers[c].demand);
+    }
+    auto relatedness = [&](int a, int b) {
+        return 9.0 * data.distance[a][b] / (2.0 * max_distance)
+            + 3.0 * std::fabs(customers[a].ready - customers[b].ready) / max_time
+            + 2.0 * std::abs(customers[a].demand - customers[b].demand) / max_demand;
+    };
+
+    std::vector<int> removed;
+    int seed_pos = rng() % remaining.size();
+    removed.push_back(remaining[seed_pos]);
+    remaining.erase(remaining.begin() + seed_pos);
+    while ((int)removed.size() < count && !remaining.empty()) {
+        int from = removed[rng() % removed.size()];
+        std::sort(remaining.begin(), remaining.end(), [&](int a, int b) { return relatedness(from, a) < relatedness(from, b); });
+        int k = biased_index(rng, remaining.size(), 6.0);
+        removed.push_back(remaining[k]);
+        remaining.erase(remaining.begin() + k);
+    }
+    remove_customers(data, state, removed);
+    return removed;
+}
+
+// removes whole random routes until enough customers are out
+template <class Distance>
+std::vector<int> destroy_routes(const ProblemData<Distance>& data, SearchState& state, std::mt19937& rng, int count) {
+    std::vector<int> order(state.routes.size());
+    for (int r = 0; r < (int)order.size(); r++) order[r] = r;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<int> removed;
+    for (int r : order) {
+        if ((int)removed.size() >= count) break;
+        removed.insert(removed.end(), state.routes[r].sequence.begin(), state.routes[r].sequence.end());
+    }
+    remove_customers(data, state, removed);
+    return removed;
+}
+
+struct InsertionOption {
+    int route = -1;       // -1 means a new route
+    int position = 0;
+    double delta = std::numeric_limits<double>::infinity();
+};
+
+// cheapest feasible insertion of a customer into one route, O(1) per position
+template <class Distance>
+InsertionOption best_insertion(const ProblemData<Distance>& data, const SearchState& state, int customer, int r) {
+    InsertionOption best;
+    const Route& route = state.routes[r];
+    if (route.load + data.customers[customer].demand > data.capacity) return best;
+    const RouteSegments& rs = state.segments[r];
+    Segment single = single_segment(data.customers[customer], customer);
+    for (int p = 0; p <= (int)route.sequence.size(); p++) {
+        int before = p > 0 ? route.sequence[p - 1] : data.depot_index;
+        int after = p < (int)route.sequence.size() ? route.sequence[p] : data.depot_index;
+        if (!data.compatible.can_follow(before, customer) || !data.compatible.can_follow(customer, after)) continue;
+        Segment joined = concat_segments(concat_segments(rs.prefix[p], single, data.distance), rs.suffix[p], data.distance);
+        if (!segment_feasible(joined)) continue;
+        double delta = segment_cost(joined) - route.cost;
+        if (delta < best.delta) best = { r, p, delta };
+    }
+    return best;
+}
+
+// Greedy (regret = 1) and regret-k insertion of the pool. Every pool customer keeps
+// its best insertion into the routes that contain one of its neighbors; after an
+// insertion only the options on the modified route are recomputed.
+template <class Distance>
+void repair_regret(const ProblemData<Distance>& data, SearchState& state, std::vector<int> pool, int regret) {
+    const Segment depot_start = depot_start_segment(data.depot_index);
+    const Segment depot_end = depot_end_segment(data.customers[data.depot_index], data.depot_index);
+    std::vector<double> alone(pool.size());
+    std::vector<std::vector<InsertionOption>> options(pool.size());
+    for (int k = 0; k < (int)pool.size(); k++) {
+        int u = pool[k];
+        Segment solo = concat_segments(concat_segments(depot_start, single_segment(data.customers[u], u), data.distance), depot_end, data.distance);
+        alone[k] = segment_cost(solo);
+        for (int v : data.neighbors[u]) {
+            int r = state.route_of[v];
+            if (r < 0) continue;
+            bool known = false;
+            for (auto& o : options[k]) known |= o.route == r;
+            if (known) continue;
+            options[k].push_back(best_insertion(data, state, u, r));
+            options[k].back().route = r;
+        }
+    }
+
+    std::vector<double> top(regret);
+    while (!pool.empty()) {
+        // customer with the largest regret, ties broken by the cheaper insertion
+        int pick = -1;
+        double pick_regret = -1.0, pick_cost = 0.0;
+        for (int k = 0; k < (int)pool.size(); k++) {
+            std::fill(top.begin(), top.end(), alone[k]);
+            for (auto& o : options[k]) {
+                if (o.delta >= top.back()) continue;
+                int t = regret - 1;
+                while (t > 0 && top[t - 1] > o.delta) { top[t] = top[t - 1]; t--; }
+                top[t] = o.delta;
+            }
+            double value = 0.0;
+            for (int t = 1; t < regret; t++) value += top[t] - top[0];
+            if (pick < 0 || value > pick_regret + 1e-9 || (std::fabs(value - pick_regret) <= 1e-9 && top[0] < pick_cost)) {
+                pick = k;
+                pick_regret = value;
+                pick_cost = top[0];
+            }
+        }
+
+        int u = pool[pick];
+        InsertionOption chosen;
+        chosen.delta = alone[pick];
+        for (auto& o : options[pick])
+            if (o.delta < chosen.delta) chosen = o;
+        int r = chosen.route;
+        if (r < 0) {
+            Route fresh;
+            state.routes.push_back(fresh);
+            state.segments.push_back(RouteSegments());
+            r = state.routes.size() - 1;
+            chosen.position = 0;
+        }
+        state.routes[r].sequence.insert(state.routes[r].sequence.begin() + chosen.position, u);
+        state.routes[r].load += data.customers[u].demand;
+        refresh_route(data, state, r);
+
+        pool[pick] = pool.back();
+        pool.pop_back();
+        alone[pick] = alone.back();
+        alone.pop_back();
+        options[pick] = std::move(options.back());
+        options.pop_back();
+
+        // incremental update: only options on route r changed
+        for (int k = 0; k < (int)pool.size(); k++) {
+            bool known = false;
+            for (auto& o : options[k]) {
+                if (o.route != r) continue;
+                o = best_insertion(data, state, pool[k], r);
+                o.route = r;
+                known = true;
+            }
+            if (!known) {
+                const std::vector<int>& near = data.neighbors[pool[k]];
+                if (std::find(near.begin(), near.end(), u) != near.end()) {
+                    options[k].push_back(best_insertion(data, state, pool[k], r));
+                    options[k].back().route = r;
+                }
+            }
+        }
+    }
+}
+
+struct AlnsParams {
+    int max_iterations = 5000;
+    int segment_length = 100;     // iterations between weight updates
+    double reaction = 0.1;
+    double min_remove_share = 0.05, max_remove_share = 0.2;
+    int max_remove = 400;
+    double target_cost = 0.0;
+    ImprovementCallback on_improvement;
+    unsigned seed = 0;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+double solution_cost(const std::vector<Route>& routes) {
+    double total = 0.0;
+    for (auto& r : routes) total += r.cost;
+    return total;
+}
+
+// roulette wheel over adaptive weights
+int pick_operator(const std::vector<double>& weights, std::mt19937& rng) {
+    double total = 0.0;
+    for (double w : weights) total += w;
+    double x = std::uniform_real_distribution<double>(0.0, total)(rng);
+    for (int k = 0; k < (int)weights.size(); k++) {
+        x -= weights[k];
+        if (x <= 0.0) return k;
+    }
+    return weights.size() - 1;
+}
+
+// Adaptive Large Neighborhood Search with simulated-annealing acceptance.
+// Temperature starts where a 5% worse solution is accepted with probability 1/2
+// and cools geometrically with the consumed share of the time / iteration budget.
+template <class Distance>
+TabuResult alns_search(const ProblemData<Distance>& data, const std::vector<Route>& start, const AlnsParams& params) {
+    const char* destroy_names[] = { "random", "worst", "related", "route" };
+    const char* repair_names[] = { "greedy", "regret-2", "regret-3" };
+    const int repair_regrets[] = { 1, 2, 3 };
+    constexpr double SCORE_BEST = 33.0, SCORE_BETTER = 9.0, SCORE_ACCEPTED = 13.0;
+
+    std::mt19937 rng(params.seed);
+    SearchState current;
+    current.routes = start;
+    refresh_all_routes(data, current);
+    double current_cost = solution_cost(current.routes);
+
+    TabuResult result;
+    result.best_solution = current.routes;
+    result.best_cost = current_cost;
+
+    int customers_count = data.customers.size() - 1;
+    int min_remove = std::max(1, (int)(params.min_remove_share * customers_count));
+    int max_remove = std::max(min_remove, std::min(params.max_remove, (int)(params.max_remove_share * customers_count)));
+
+    std::vector<double> destroy_weights(4, 1.0), repair_weights(3, 1.0);
+    std::vector<double> destroy_scores(4, 0.0), repair_scores(3, 0.0);
+    std::vector<int> destroy_uses(4, 0), repair_uses(3, 0);
+
+    double start_temperature = -0.05 * current_cost / std::log(0.5);
+    double end_temperature = start_temperature * 0.002;
+    auto started = std::chrono::steady_clock::now();
+    double budget = std::chrono::duration<double>(params.deadline - started).count();
+
+    for (int iteration = 0; iteration < params.max_iterations && result.best_cost > params.target_cost
+        && std::chrono::steady_clock::now() < params.deadline; iteration++) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        double progress = std::max((double)iteration / params.max_iterations, budget > 0 ? elapsed / budget : 1.0);
+        double temperature = start_temperature * std::pow(end_temperature / start_temperature, progress);
+
+        int d = pick_operator(destroy_weights, rng);
+        int r = pick_operator(repair_weights, rng);
+        int count = min_remove + rng() % (max_remove - min_remove + 1);
+
+        SearchState candidate = current;
+        std::vector<int> pool;
+        switch (d) {
+        case 0: pool = destroy_random(data, candidate, rng, count); break;
+        case 1: pool = destroy_worst(data, candidate, rng, count); break;
+        case 2: pool = destroy_related(data, candidate, rng, count); break;
+        default: pool = destroy_routes(data, candidate, rng, count); break;
+        }
+        repair_regret(data, candidate, pool, repair_regrets[r]);
+        double candidate_cost = solution_cost(candidate.routes);
+        result.iterations++;
+
+        double score = 0.0;
+        if (candidate_cost < result.best_cost - 1e-9) {
+            result.best_cost = candidate_cost;
+            result.best_solution = candidate.routes;
+            score = SCORE_BEST;
+            if (params.on_improvement) params.on_improvement(result.best_solution, result.best_cost, result.iterations);
+        }
+        bool accept = candidate_cost < current_cost
+            || std::uniform_real_distribution<double>(0.0, 1.0)(rng) < std::exp((current_cost - candidate_cost) / temperature);
+        if (accept) {
+            if (score == 0.0) score = candidate_cost < current_cost ? SCORE_BETTER : SCORE_ACCEPTED;
+            current = std::move(candidate);
+            current_cost = candidate_cost;
+        }
+        destroy_scores[d] += score;
+        repair_scores[r] += score;
+        destroy_uses[d]++;
+        repair_uses[r]++;
+
+        if ((iteration + 1) % params.segment_length == 0) {
+            for (int k = 0; k < 4; k++) {
+                if (destroy_uses[k]) destroy_weights[k] = (1 - params.reaction) * destroy_weights[k] + params.reaction * destroy_scores[k] / destroy_uses[k];
+                destroy_weights[k] = std::max(destroy_weights[k], 0.05);
+                destroy_scores[k] = 0.0;
+                destroy_uses[k] = 0;
+            }
+            for (int k = 0; k < 3; k++) {
+                if (repair_uses[k]) repair_weights[k] = (1 - params.reaction) * repair_weights[k] + params.reaction * repair_scores[k] / repair_uses[k];
+                repair_weights[k] = std::max(repair_weights[k], 0.05);
+                repair_scores[k] = 0.0;
+                repair_uses[k] = 0;
+            }
+        }
+    }
+
+    std::string weights = "ALNS operator weights:";
+    for (int k = 0; k < 4; k++) weights += std::string(" ") + destroy_names[k] + "=" + format_cost(destroy_weights[k]);
+    for (int k = 0; k < 3; k++) weights += std::string(" ") + repair_names[k] + "=" + format_cost(repair_weights[k]);
+    result.notes.push_back(weights);
+    return result;
+}
+
+// --- HYBRID GENETIC SEARCH ---
+
+// Local descent used as education: best improving swap / insert / CROSS move
+// from the move store until no improving move is left.
+template <class Distance>
+void local_descent(const ProblemData<Distance>& data, std::vector<Route>& routes, int cross_max_len,
+    std::chrono::steady_clock::time_point deadline) {
+    SearchState state;
+    state.routes = routes;
+    MoveStore store(1);
+    bool rebuild_store = true;
+    while (std::chrono::steady_clock::now() < deadline) {
+        int route_count = state.routes.size();
+        if (rebuild_store) {
+            refresh_all_routes(data, state);
+            store.reset(route_count);
+            for (int route1 = 0; route1 < route_count; route1++)
+                for (int route2 = route1 + 1; route2 < route_count; route2++)
+                    store.set_pair(route1, route2, evaluate_route_pair(data, state, route1, route2, cross_max_len, 0.0));
+            rebuild_store = false;
+        }
+        MoveStore::Entry entry;
+        if (!store.pop_best(entry) || store.move(entry).cost > -1e-6) break;
+        Move chosen = store.move(entry);
+        apply_move(state.routes, data.customers, chosen);
+        if (state.routes[chosen.route1].sequence.empty() || state.routes[chosen.route2].sequence.empty()) {
+            remove_empty_routes(state.routes);
+            rebuild_store = true;
+            continue;
+        }
+        refresh_route(data, state, chosen.route1);
+        refresh_route(data, state, chosen.route2);
+        store.touch(chosen.route1);
+        store.touch(chosen.route2);
+        for (int other = 0; other < route_count; other++) {
+            for (int touched : { chosen.route1, chosen.route2 }) {
+                if (other == touched || (other == chosen.route1 && touched == chosen.route2)) continue;
+                int lo = std::min(other, touched), hi = std::max(other, touched);
+                store.set_pair(lo, hi, evaluate_route_pair(data, state, lo, hi, cross_max_len, 0.0));
+            }
+        }
+        store.compact();
+    }
+    refresh_all_routes(data, state);
+    routes = state.routes;
+}
+
+// Local descent restricted to the focus routes and the routes holding neighbors of
+// their customers; after a move only the two changed routes stay in focus. Used by
+// re-planning, where evaluating all route pairs would not fit the latency budget.
+template <class Distance>
+void focused_descent(const ProblemData<Distance>& data, SearchState& state, std::vector<int> focus, int cross_max_len,
+    std::chrono::steady_clock::time_point deadline) {
+    while (!focus.empty() && std::chrono::steady_clock::now() < deadline) {
+        Move best;
+        bool found = false;
+        for (int f : focus) {
+            std::vector<int> partners;
+            for (int c : state.routes[f].sequence)
+                for (int v : data.neighbors[c]) {
+                    int r = state.route_of[v];
+                    if (r >= 0 && r != f && std::find(partners.begin(), partners.end(), r) == partners.end()) partners.push_back(r);
+                }
+            for (int g : partners)
+                for (auto& m : evaluate_route_pair(data, state, std::min(f, g), std::max(f, g), cross_max_len, 0.0))
+                    if (m.cost < -1e-6 && (!found || m.cost < best.cost)) {
+                        best = m;
+                        found = true;
+                    }
+        }
+        if (!found) break;
+        apply_move(state.routes, data.customers, best);
+        bool empty1 = state.routes[best.route1].sequence.empty(), empty2 = state.routes[best.route2].sequence.empty();
+        if (empty1 || empty2) {
+            int emptied = empty1 ? best.route1 : best.route2, kept = empty1 ? best.route2 : best.route1;
+            remove_empty_routes(state.routes);
+            refresh_all_routes(data, state);
+            focus = { kept > emptied ? kept - 1 : kept };
+        }
+        else {
+            refresh_route(data, state, best.route1);
+            refresh_route(data, state, best.route2);
+            focus = { best.route1, best.route2 };
+        }
+    }
+}
+
+// Split: optimal cutting of a giant tour into routes (shortest path over the tour).
+// A route i..j is extended one customer at a time by segment concatenation and the
+// extension stops at the first capacity or time-window violation, so the work is
+// O(n * customers per route), linear in n for a fixed vehicle capacity.
+template <class Distance>
+std::vector<Route> split_giant_tour(const ProblemData<Distance>& data, const std::vector<int>& tour) {
+    int n = tour.size();
+    const Segment depot_start = depot_start_segment(data.depot_index);
+    const Segment depot_end = depot_end_segment(data.customers[data.depot_index], data.depot_index);
+    std::vector<double> best(n + 1, std::numeric_limits<double>::infinity());
+    std::vector<int> pred(n + 1, -1);
+    best[0] = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (best[i] == std::numeric_limits<double>::infinity()) continue;
+        Segment seg = depot_start;
+        for (int j = i; j < n; j++) {
+            seg = concat_segments(seg, single_segment(data.customers[tour[j]], tour[j]), data.distance);
+            if (seg.load > data.capacity) break;
+            Segment full = concat_segments(seg, depot_end, data.distance);
+            if (!segment_feasible(full)) break;
+            double cost = best[i] + segment_cost(full);
+            if (cost < best[j + 1]) {
+                best[j + 1] = cost;
+                pred[j + 1] = i;
+            }
+        }
+    }
+    std::vector<Route> routes;
+    if (pred[n] < 0 && n > 0) return routes;
+    for (int j = n; j > 0; j = pred[j]) {
+        Route r;
+        r.sequence.assign(tour.begin() + pred[j], tour.begin() + j);
+        for (int c : r.sequence) r.load += data.customers[c].demand;
+        routes.push_back(r);
+    }
+    std::reverse(routes.begin(), routes.end());
+    return routes;
+}
+
+struct Individual {
+    std::vector<int> tour;
+    std::vector<Route> routes;
+    double cost = std::numeric_limits<double>::infinity();
+    // neighbors in the routes (depot = depot_index), used by the broken-pairs distance
+    std::vector<int> successor, predecessor;
+    double biased_fitness = 0.0;
+};
+
+template <class Distance>
+void finish_individual(const ProblemData<Distance>& data, Individual& ind) {
+    ind.tour.clear();
+    ind.cost = 0.0;
+    ind.successor.assign(data.customers.size(), data.depot_index);
+    ind.predecessor.assign(data.customers.size(), data.depot_index);
+    for (auto& r : ind.routes) {
+        auto fc = route_feasible_and_cost(data.customers, data.depot_index, data.distance, r.sequence);
+        r.cost = fc.second;
+        ind.cost += fc.second;
+        for (int k = 0; k < (int)r.sequence.size(); k++) {
+            ind.tour.push_back(r.sequence[k]);
+            if (k > 0) ind.predecessor[r.sequence[k]] = r.sequence[k - 1];
+            if (k + 1 < (int)r.sequence.size()) ind.successor[r.sequence[k]] = r.sequence[k + 1];
+        }
+    }
+}
+
+// share of customers whose neighbors differ between two solutions
+template <class Distance>
+double broken_pairs_distance(const ProblemData<Distance>& data, const Individual& a, const Individual& b) {
+    int differ = 0, count = 0;
+    for (int c = 0; c < (int)data.customers.size(); c++) {
+        if (c == data.depot_index) continue;
+        count++;
+        bool same = (a.successor[c] == b.successor[c] && a.predecessor[c] == b.predecessor[c])
+            || (a.successor[c] == b.predecessor[c] && a.predecessor[c] == b.successor[c]);
+        if (!same) differ++;
+    }
+    return count ? (double)differ / count : 0.0;
+}
+
+// order crossover on giant tours
+std::vector<int> order_crossover(const std::vector<int>& p1, const std::vector<int>& p2, std::mt19937& rng, int customer_count) {
+    int n = p1.size();
+    std::vector<int> child(n, -1);
+    std::vector<char> used(customer_count, 0);
+    int start = rng() % n, end = rng() % n;
+    if (start > end) std::swap(start, end);
+    for (int k = start; k <= end; k++) {
+        child[k] = p1[k];
+        used[p1[k]] = 1;
+    }
+    int pos = (end + 1) % n;
+    for (int k = 0; k < n; k++) {
+        int c = p2[(end + 1 + k) % n];
+        if (used[c]) continue;
+        child[pos] = c;
+        pos = (pos + 1) % n;
+    }
+    return child;
+}
+
+struct HgsParams {
+    int population_size = 25;      // mu
+    int generation_size = 40;      // lambda
+    int elite = 4;
+    int close_count = 5;
+    int max_no_improvement = 500;  // offspring without a new best
+    int threads = 1;
+    int cross_max_len = 3;
+    double target_cost = 0.0;
+    ImprovementCallback on_improvement;
+    unsigned seed = 0;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+// biased fitness = cost rank + (1 - elite / size) * diversity rank, both scaled to [0, 1]
+template <class Distance>
+void update_biased_fitness(const ProblemData<Distance>& data, std::vector<Individual>& population, const HgsParams& params) {
+    int size = population.size();
+    if (size <= 1) {
+        for (auto& ind : population) ind.biased_fitness = 0.0;
+        return;
+    }
+    std::vector<double> diversity(size, 0.0);
+    for (int a = 0; a < size; a++) {
+        std::vector<double> dist;
+        for (int b = 0; b < size; b++)
+            if (a != b) dist.push_back(broken_pairs_distance(data, population[a], population[b]));
+        int take = std::min<int>(params.close_count, dist.size());
+        std::partial_sort(dist.begin(), dist.begin() + take, dist.end());
+        for (int k = 0; k < take; k++) diversity[a] += dist[k] / take;
+    }
+    std::vector<int> by_cost(size), by_diversity(size);
+    for (int k = 0; k < size; k++) by_cost[k] = by_diversity[k] = k;
+    std::sort(by_cost.begin(), by_cost.end(), [&](int a, int b) { return population[a].cost < population[b].cost; });
+    std::sort(by_diversity.begin(), by_diversity.end(), [&](int a, int b) { return diversity[a] > diversity[b]; });
+    std::vector<double> cost_rank(size), diversity_rank(size);
+    for (int k = 0; k < size; k++) {
+        cost_rank[by_cost[k]] = (double)k / (size - 1);
+        diversity_rank[by_diversity[k]] = (double)k / (size - 1);
+    }
+    double weight = 1.0 - (double)std::min(params.elite, size) / size;
+    for (int k = 0; k < size; k++) population[k].biased_fitness = cost_rank[k] + weight * diversity_rank[k];
+}
+
+// drops the worst individuals by biased fitness (clones first) down to mu
+template <class Distance>
+void select_survivors(const ProblemData<Distance>& data, std::vector<Individual>& population, const HgsParams& params) {
+    while ((int)population.size() > params.population_size) {
+        update_biased_fitness(data, population, params);
+        int worst = -1;
+        bool worst_clone = false;
+        for (int k = 0; k < (int)population.size(); k++) {
+            bool clone = false;
+            for (int o = 0; o < (int)population.size() && !clone; o++)
+                clone = o != k && broken_pairs_distance(data, population[k], population[o]) < 1e-9;
+            if (worst < 0 || (clone && !worst_clone) || (clone == worst_clone && population[k].biased_fitness > population[worst].biased_fitness)) {
+                worst = k;
+                worst_clone = clone;
+            }
+        }
+        population.erase(population.begin() + worst);
+    }
+    update_biased_fitness(data, population, params);
+}
+
+int binary_tournament(const std::vector<Individual>& population, std::mt19937& rng) {
+    int a = rng() % population.size(), b = rng() % population.size();
+    return population[a].biased_fitness < population[b].biased_fitness ? a : b;
+}
+
+// Population-based search on giant tours: OX crossover, Split decoding and local
+// descent as education. Offspring of one batch are educated in parallel threads.
+template <class Distance>
+TabuResult hgs_search(const ProblemData<Distance>& data, const std::vector<Route>& start, const HgsParams& params) {
+    std::mt19937 rng(params.seed);
+    int customer_count = data.customers.size();
+    int threads = std::max(1, params.threads);
+    std::vector<Individual> population;
+
+    auto educate = [&](Individual& ind) {
+        ind.routes = split_giant_tour(data, ind.tour);
+        local_descent(data, ind.routes, params.cross_max_len, params.deadline);
+        finish_individual(data, ind);
+    };
+
+    // initial population: the constructed solution and random giant tours
+    Individual first;
+    first.routes = start;
+    finish_individual(data, first);
+    std::vector<Individual> initial(2 * params.population_size);
+    for (auto& ind : initial) {
+        ind.tour = first.tour;
+        std::shuffle(ind.tour.begin(), ind.tour.end(), rng);
+    }
+    parallel_for(threads, initial.size(), [&](int k) { educate(initial[k]); });
+    local_descent(data, first.routes, params.cross_max_len, params.deadline);
+    finish_individual(data, first);
+    population.push_back(first);
+    for (auto& ind : initial)
+        if (!ind.routes.empty()) population.push_back(std::move(ind));
+    select_survivors(data, population, params);
+
+    TabuResult result;
+    result.best_solution = first.routes;
+    result.best_cost = first.cost;
+    for (auto& ind : population)
+        if (ind.cost < result.best_cost) {
+            result.best_cost = ind.cost;
+            result.best_solution = ind.routes;
+        }
+
+    int no_improvement = 0;
+    while (no_improvement < params.max_no_improvement && result.best_cost > params.target_cost
+        && std::chrono::steady_clock::now() < params.deadline) {
+        // parents are drawn up front, crossover + split + education run in parallel
+        std::vector<Individual> offspring(threads);
+        std::vector<unsigned> seeds(threads);
+        for (int k = 0; k < threads; k++) {
+            const Individual& p1 = population[binary_tournament(population, rng)];
+            const Individual& p2 = population[binary_tournament(population, rng)];
+            std::mt19937 child_rng(rng());
+            offspring[k].tour = order_crossover(p1.tour, p2.tour, child_rng, customer_count);
+        }
+        parallel_for(threads, threads, [&](int k) { educate(offspring[k]); });
+
+        for (auto& child : offspring) {
+            if (child.routes.empty()) continue;
+            result.iterations++;
+            if (child.cost < result.best_cost - 1e-9) {
+                result.best_cost = child.cost;
+                result.best_solution = child.routes;
+                no_improvement = 0;
+                if (params.on_improvement) params.on_improvement(result.best_solution, result.best_cost, result.iterations);
+            }
+            else {
+                no_improvement++;
+            }
+            population.push_back(std::move(child));
+        }
+        if ((int)population.size() >= params.population_size + params.generation_size)
+            select_survivors(data, population, params);
+        else
+            update_biased_fitness(data, population, params);
+    }
+    return result;
+}
+
+// --- ROUTE MINIMIZATION ---
+
+// Best insertion of ejection-pool customers into every route. An entry is valid
+// while its stamp matches the route version, so after a change only the modified
+// route is re-evaluated.
+class InsertionCostCache {
+public:
+    void reset(int routes) {
+        version.assign(routes, 1);
+        entries.clear();
+    }
+
+    void touch(int route) { version[route]++; }
+
+    template <class Distance>
+    InsertionOption best(const ProblemData<Distance>& data, const SearchState& state, int customer) {
+        std::vector<Entry>& row = entries[customer];
+        row.resize(version.size());
+        InsertionOption best_option;
+        for (int r = 0; r < (int)version.size(); r++) {
+            if (row[r].stamp != version[r]) {
+                row[r].option = best_insertion(data, state, customer, r);
+                row[r].stamp = version[r];
+            }
+            if (row[r].option.delta < best_option.delta) best_option = row[r].option;
+        }
+        return best_option;
+    }
+
+private:
+    struct Entry {
+        unsigned stamp = 0;
+        InsertionOption option;
+    };
+    std::vector<unsigned> version;
+    std::unordered_map<int, std::vector<Entry>> entries;
+};
+
+struct EjectionOption {
+    int route = -1, insert_pos = 0, eject_pos = 0;
+    long long penalty = std::numeric_limits<long long>::max();
+    double cost = std::numeric_limits<double>::infinity();
+};
+
+// Insertion of a customer into route r that ejects one of its customers. The ejected
+// customer with the smallest penalty counter wins, ties go to the cheaper route.
+// For a fixed ejected position the part between the two positions is grown one
+// customer at a time, so the route costs O(|r|^2) segment concatenations.
+template <class Distance>
+void best_ejection(const ProblemData<Distance>& data, const SearchState& state, int customer, int r,
+    const std::vector<long long>& penalty, EjectionOption& best) {
+    const std::vector<int>& seq = state.routes[r].sequence;
+    const RouteSegments& rs = state.segments[r];
+    const Distance& d = data.distance;
+    int m = seq.size();
+    Segment single = single_segment(data.customers[customer], customer);
+    for (int q = 0; q < m; q++) {
+        int ejected = seq[q];
+        if (penalty[ejected] > best.penalty) continue;
+        if (state.routes[r].load - data.customers[ejected].demand + data.customers[customer].demand > data.capacity) continue;
+        auto consider = [&](const Segment& full, int insert_pos) {
+            if (!segment_feasible(full)) return;
+            double cost = segment_cost(full);
+            if (penalty[ejected] < best.penalty || cost < best.cost) best = { r, insert_pos, q, penalty[ejected], cost };
+        };
+        // customer inserted before the ejected one: prefix[p] + u + seq[p..q-1] + suffix[q+1]
+        Segment middle;
+        for (int p = q; p >= 0; p--) {
+            if (p < q) middle = concat_segments(single_segment(data.customers[seq[p]], seq[p]), middle, d);
+            consider(concat_segments(concat_segments(concat_segments(rs.prefix[p], single, d), middle, d), rs.suffix[q + 1], d), p);
+        }
+        // customer inserted after it: prefix[q] + seq[q+1..p-1] + u + suffix[p]
+        middle = Segment();
+        for (int p = q + 2; p <= m; p++) {
+            middle = concat_segments(middle, single_segment(data.customers[seq[p - 1]], seq[p - 1]), d);
+            consider(concat_segments(concat_segments(concat_segments(rs.prefix[q], middle, d), single, d), rs.suffix[p], d), p);
+        }
+    }
+}
+
+// Fleet reduction: removes the smallest route, puts its customers into an ejection
+// pool and reinserts them, directly when possible and otherwise by ejecting the
+// least troublesome customer of another route back into the pool. A route that
+// cannot be emptied within max_pool_steps is restored and the next one is tried.
+// Stops after max_failures routes in a row could not be removed (Solomon needs at
+// most 16 failed attempts before a success, m2k removes nothing after the first 0.7 s).
+template <class Distance>
+int reduce_fleet(const ProblemData<Distance>& data, std::vector<Route>& routes, int min_routes,
+    std::chrono::steady_clock::time_point deadline, unsigned seed, int max_pool_steps = 2000, int max_failures = 20) {
+    std::mt19937 rng(seed);
+    SearchState state;
+    state.routes = routes;
+    refresh_all_routes(data, state);
+    std::vector<long long> penalty(data.customers.size(), 1);
+    int removed_routes = 0, failures = 0;
+
+    std::vector<int> order;
+    size_t next_candidate = 0;
+    bool reorder = true;
+    while ((int)state.routes.size() > min_routes && std::chrono::steady_clock::now() < deadline) {
+        if (reorder) {
+            order.resize(state.routes.size());
+            for (int r = 0; r < (int)order.size(); r++) order[r] = r;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return state.routes[a].sequence.size() < state.routes[b].sequence.size(); });
+            next_candidate = 0;
+            reorder = false;
+        }
+        if (next_candidate >= order.size() || failures >= max_failures) break;
+
+        std::vector<Route> backup = state.routes;
+        int target = order[next_candidate++];
+        std::vector<int> pool = state.routes[target].sequence;
+        state.routes.erase(state.routes.begin() + target);
+        refresh_all_routes(data, state);
+        InsertionCostCache cache;
+        cache.reset(state.routes.size());
+        std::shuffle(pool.begin(), pool.end(), rng);
+
+        int steps = 0;
+        while (!pool.empty() && steps++ < max_pool_steps && std::chrono::steady_clock::now() < deadline) {
+            int u = pool.back();
+            pool.pop_back();
+            InsertionOption direct = cache.best(data, state, u);
+            if (direct.route >= 0) {
+                std::vector<int>& seq = state.routes[direct.route].sequence;
+                seq.insert(seq.begin() + direct.position, u);
+                state.routes[direct.route].load += data.customers[u].demand;
+                refresh_route(data, state, direct.route);
+                cache.touch(direct.route);
+                continue;
+            }
+            // squeeze by ejection
+            penalty[u]++;
+            EjectionOption eject;
+            for (int r = 0; r < (int)state.routes.size(); r++) best_ejection(data, state, u, r, penalty, eject);
+            if (eject.route < 0) {
+                pool.push_back(u);
+                break;
+            }
+            std::vector<int>& seq = state.routes[eject.route].sequence;
+            int ejected = seq[eject.eject_pos];
+            seq.erase(seq.begin() + eject.eject_pos);
+            seq.insert(seq.begin() + (eject.insert_pos > eject.eject_pos ? eject.insert_pos - 1 : eject.insert_pos), u);
+            state.routes[eject.route].load += data.customers[u].demand - data.customers[ejected].demand;
+            refresh_route(data, state, eject.route);
+            cache.touch(eject.route);
+            pool.insert(pool.begin() + rng() % (pool.size() + 1), ejected);
+        }
+
+        if (pool.empty()) {
+            removed_routes++;
+            failures = 0;
+            reorder = true;
+        }
+        else {
+            failures++;
+            state.routes = std::move(backup);
+            refresh_all_routes(data, state);
+        }
+    }
+    routes = state.routes;
+    return removed_routes;
+}
+
+// --- API BIBLIOTEKI ---
+
+DistanceMatrix::DistanceMatrix(size_t n) : n(n), stride(n), owned(n * n, 0.0) {
+    values = owned.data();
+}
+
+DistanceMatrix::~DistanceMatrix() {
+    if (!mapping) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mapped_bytes);
+#endif
+}
+
+DistanceMatrix::DistanceMatrix(DistanceMatrix&& other) noexcept {
+    *this = std::move(other);
+}
+
+// swapping keeps values valid, a vector keeps its buffer; the old content is
+// released with other
+DistanceMatrix& DistanceMatrix::operator=(DistanceMatrix&& other) noexcept {
+    std::swap(n, other.n);
+    std::swap(stride, other.stride);
+    std::swap(values, other.values);
+    std::swap(owned, other.owned);
+    std::swap(mapping, other.mapping);
+    std::swap(mapped_bytes, other.mapped_bytes);
+    return *this;
+}
+
+DistanceMatrix DistanceMatrix::map_file(const std::string& path, size_t n) {
+    size_t bytes = n * n * sizeof(double);
+    DistanceMatrix matrix;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open matrix " + path + ".");
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart != bytes) {
+        CloseHandle(file);
+        throw std::runtime_error("Matrix " + path + " does not hold " + std::to_string(n) + " x " + std::to_string(n) + " doubles.");
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    // the view keeps the mapping alive
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    if (!view) throw std::runtime_error("Cannot map matrix " + path + ".");
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open matrix " + path + ".");
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size != bytes) {
+        close(fd);
+        throw std::runtime_error("Matrix " + path + " does not hold " + std::to_string(n) + " x " + std::to_string(n) + " doubles.");
+    }
+    void* view = bytes ? mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+    // the mapping stays valid after close
+    close(fd);
+    if (view == MAP_FAILED) throw std::runtime_error("Cannot map matrix " + path + ".");
+#endif
+    matrix.n = matrix.stride = n;
+    matrix.mapping = view;
+    matrix.mapped_bytes = bytes;
+    matrix.values = (double*)view;
+    return matrix;
+}
+
+DistanceMatrix DistanceMatrix::read_text(const std::string& path, size_t n) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Cannot open matrix " + path + ".");
+    DistanceMatrix matrix(n);
+    for (size_t i = 0; i < n * n; i++)
+        if (!(file >> matrix.values[i])) throw std::runtime_error("Matrix " + path + " has fewer than " + std::to_string(n * n) + " values.");
+    return matrix;
+}
+
+void DistanceMatrix::resize(size_t new_n) {
+    if (new_n <= n) return;
+    // slots beyond n are zero already
+    if (new_n > stride) {
+        size_t new_stride = std::max(new_n, stride + stride / 4 + 16);
+        std::vector<double> grown(new_stride * new_stride, 0.0);
+        for (size_t i = 0; i < n; i++) std::copy(values + i * stride, values + i * stride + n, grown.begin() + i * new_stride);
+        owned = std::move(grown);
+        values = owned.data();
+        stride = new_stride;
+    }
+    n = new_n;
+}
+
+uint64_t DistanceMatrix::hash() const {
+    uint64_t h = mix_hash(n);
+    for (size_t i = 0; i < n; i++) {
+        const double* row = (*this)[i];
+        for (size_t j = 0; j < n; j++) {
+            uint64_t b;
+            std::memcpy(&b, &row[j], sizeof b);
+            h = mix_hash(h ^ b);
+        }
+    }
+    return h;
+}
+
+Instance Instance::from_file(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Error opening file.");
+    return parse(file);
+}
+
+Instance Instance::parse(std::istream& file) {
+    // getting data
+    Instance instance;
+    std::string skip_line;
+    for (int i = 0; i < 4; i++) std::getline(file, skip_line);
+    file >> instance.vehicles >> instance.capacity;
+    for (int i = 0; i < 5; i++) std::getline(file, skip_line);
+
+    int id, demand;
+    double x, y, ready, due, service;
+    while (file >> id >> x >> y >> demand >> ready >> due >> service) {
+        instance.customers.emplace_back(id, x, y, demand, ready, due, service);
+    }
+    if (instance.customers.empty()) throw std::runtime_error("No customers in file.");
+    return instance;
+}
+
+uint64_t Instance::hash() const {
+    auto bits = [](double value) {
+        uint64_t b;
+        std::memcpy(&b, &value, sizeof b);
+        return b;
+    };
+    uint64_t h = mix_hash((uint64_t)vehicles) ^ mix_hash(bits(capacity) + 1);
+    for (auto& c : customers) {
+        h = mix_hash(h ^ (uint64_t)c.id);
+        for (double v : { c.x, c.y, (double)c.demand, c.ready, c.due, c.service }) h = mix_hash(h ^ bits(v));
+    }
+    if (distances) h = mix_hash(h ^ distances->hash());
+    return h;
+}
+
+double Solution::gap_percent() const {
+    return lower_bound > 0.0 ? 100.0 * (cost - lower_bound) / lower_bound : 0.0;
+}
+
+Solution Solution::parse(std::istream& in) {
+    Solution solution;
+    std::string line;
+    if (!std::getline(in, line)) throw std::runtime_error("Empty solution.");
+    std::istringstream header(line);
+    int route_count;
+    if (!(header >> route_count)) throw std::runtime_error("Bad solution header.");
+    if (route_count < 0) return solution;
+    header >> solution.cost;
+    while (std::getline(in, line)) {
+        std::istringstream ids(line);
+        std::vector<int> route;
+        int id;
+        while (ids >> id) route.push_back(id);
+        if (!route.empty()) solution.routes.push_back(route);
+    }
+    if ((int)solution.routes.size() != route_count) throw std::runtime_error("Route count does not match the header.");
+    solution.feasible = true;
+    return solution;
+}
+
+Solution Solution::from_file(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Error opening file.");
+    return parse(file);
+}
+
+void Solution::write(std::ostream& out) const {
+    if (!feasible) {
+        out << "-1\n";
+        return;
+    }
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out.setf(std::ios::fixed);
+    out << std::setprecision(5);
+    out << routes.size() << " " << cost << "\n";
+    for (auto& route : routes) {
+        for (size_t k = 0; k < route.size(); k++) {
+            if (k) out << " ";
+            out << route[k];
+        }
+        out << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void Solution::save(const std::string& path) const {
+    std::ostringstream out;
+    write(out);
+    replace_file(path, out.str());
+}
+
+// New best solutions on their way from the search to the on_solution callback.
+// The search only swaps a snapshot into a single atomic slot (an unread older one
+// is dropped), a background thread takes it out and delivers it, so a slow
+// callback or disk never holds up the search.
+struct SolutionSnapshot {
+    std::vector<std::vector<int>> routes;   // customer indexes
+    double cost;
+    long long iteration;
+    double seconds;
+};
+
+SolutionSnapshot solution_snapshot(const std::vector<Route>& routes, double cost, long long iteration, double seconds) {
+    SolutionSnapshot snapshot{ {}, cost, iteration, seconds };
+    for (auto& r : routes)
+        if (!r.sequence.empty()) snapshot.routes.push_back(r.sequence);
+    return snapshot;
+}
+
+class SolutionWriter {
+public:
+    explicit SolutionWriter(std::function<void(const SolutionSnapshot&)> deliver)
+        : deliver(std::move(deliver)), thread([this]() { run(); }) {}
+    SolutionWriter(const SolutionWriter&) = delete;
+    SolutionWriter& operator=(const SolutionWriter&) = delete;
+    ~SolutionWriter() { stop(); }
+
+    // replaces a snapshot the thread has not taken yet
+    void post(SolutionSnapshot snapshot) {
+        std::unique_ptr<SolutionSnapshot> next(new SolutionSnapshot(std::move(snapshot)));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = std::move(next);
+        }
+        wake.notify_one();
+    }
+
+    // delivers the last posted snapshot and joins the thread
+    void stop() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::unique_ptr<SolutionSnapshot> snapshot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return pending || stopping; });
+                if (!pending) return;
+                snapshot = std::move(pending);
+            }
+            // poza blokadą, post() nie czeka na zapis
+            deliver(*snapshot);
+        }
+    }
+
+    std::function<void(const SolutionSnapshot&)> deliver;
+    std::unique_ptr<SolutionSnapshot> pending;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;
+};
+
+// Greedy construction: every route is extended with the customer that can start
+// service earliest. Returns false if some customer cannot be served at all.
+template <class Distance>
+bool greedy_construction(const CustomerTable& customers, int depot_index,
+    const Distance& distances, double capacity, std::vector<Route>& routes) {
+    int n = customers.size();
+    std::vector<bool> visited(n, false);
+    visited[depot_index] = true;
+    int unvisited_count = n - 1;
+
+    while (unvisited_count > 0)
+    {
+        // nowa trasa
+        Route current_route;
+        current_route.load = 0;
+        int current_location_index = depot_index;
+        double current_time = 0.0;
+        bool can_add_more_to_this_route = true;
+        while (can_add_more_to_this_route)
+        {
+            int best_customer_index = -1;
+            double best_start_time = std::numeric_limits<double>::infinity();
+
+            // szukanie najlepszego następnego klineta
+            // zaczynamy od 1 bo index 0 to depot
+            // the scan reads the field arrays and one distance row front to back
+            auto from_current = distances[current_location_index];
+            const int* demand = customers.demand.data();
+            const double* ready = customers.ready.data();
+            const double* due = customers.due.data();
+            const double* service = customers.service.data();
+            for (int i = 1; i < n; i++)
+            {
+                if (visited[i])
+                {
+                    continue;
+                }
+
+                // Czy zapotrzebowanie danego klienta mieści się w obecnej trasie
+                if (current_route.load + demand[i] > capacity)
+                {
+                    continue;
+                }
+
+                double travel_time = from_current[i];
+                double arrival_time = current_time + travel_time;
+                double start_service_time = std::max(arrival_time, ready[i]);
+
+                // przybycie poza oknem czasowym
+                if (start_service_time > due[i])
+                {
+                    continue;
+                }
+
+                // sprawdzanie powrotu
+                double departure_time = start_service_time + service[i];
+                double return_travel_time = distances[i][depot_index];
+                double return_to_deport_time = departure_time + return_travel_time;
+
+                if (return_to_deport_time > due[depot_index])
+                {
+                    continue;
+                }
+
+                // Ten klient pasuje do rozwiązania
+                if (start_service_time < best_start_time)
+                {
+                    best_start_time = start_service_time;
+                    best_customer_index = i;
+                }
+            }
+            if (best_customer_index != -1)
+            {
+                // aktualizowanie ścieżki i czasów
+                current_route.sequence.push_back(best_customer_index);
+                current_route.load += customers.demand[best_customer_index];
+                current_time = best_start_time + customers.service[best_customer_index];
+                current_location_index = best_customer_index;
+
+                visited[best_customer_index] = true;
+                unvisited_count--;
+            }
+            else
+            {
+                can_add_more_to_this_route = false;
+            }
+        }
+
+        if (!current_route.sequence.empty())
+        {
+            routes.push_back(current_route);
+        }
+        else if (unvisited_count > 0)
+        {
+            return false;
+        }
+    }
+
+    for (auto& route : routes) {
+        auto feasible_and_cost = route_feasible_and_cost(customers, depot_index, distances, route.sequence);
+        if (!feasible_and_cost.first) return false;
+        route.cost = feasible_and_cost.second;
+    }
+    return true;
+}
+
+// Clarke-Wright savings: every customer starts on its own route, then the route
+// ending at i is joined with the route starting at j, in order of decreasing saving
+// d[i][0] + d[0][j] - d[i][j] over ordered pairs, so asymmetric times are respected.
+// A join is kept when the load fits and the concatenated segments have no time warp.
+// With neighbor lists only the pairs (i, j) and (j, i) of near customers are ranked,
+// O(n k) savings instead of O(n^2).
+template <class Distance>
+bool savings_construction(const CustomerTable& customers, int depot_index,
+    const Distance& distances, double capacity, std::vector<Route>& routes,
+    const std::vector<std::vector<int>>* neighbors = nullptr) {
+    struct Saving {
+        int i, j;
+        double value;
+    };
+    int n = customers.size();
+    std::vector<Saving> savings;
+    auto add_saving = [&](int i, int j) {
+        savings.push_back({ i, j, distances[i][depot_index] + distances[depot_index][j] - distances[i][j] });
+    };
+    if (neighbors) {
+        for (int i = 0; i < n; i++) {
+            if (i == depot_index) continue;
+            for (int j : (*neighbors)[i]) {
+                add_saving(i, j);
+                add_saving(j, i);
+            }
+        }
+    }
+    else {
+        savings.reserve((size_t)(n - 1) * (n - 2));
+        for (int i = 0; i < n; i++) {
+            if (i == depot_index) continue;
+            for (int j = 0; j < n; j++)
+                if (j != i && j != depot_index) add_saving(i, j);
+        }
+    }
+    std::sort(savings.begin(), savings.end(), [](const Saving& a, const Saving& b) { return a.value > b.value; });
+
+    // trasy jako segmenty; ending_at / starting_at: route of a customer at that end, else -1
+    std::vector<Route> built;
+    std::vector<Segment> segments;
+    std::vector<int> ending_at(n, -1), starting_at(n, -1);
+    for (int i = 0; i < n; i++) {
+        if (i == depot_index) continue;
+        Route r;
+        r.sequence = { i };
+        r.load = customers[i].demand;
+        ending_at[i] = starting_at[i] = built.size();
+        built.push_back(r);
+        segments.push_back(single_segment(customers[i], i));
+    }
+    Segment depot_start = depot_start_segment(depot_index);
+    Segment depot_end = depot_end_segment(customers[depot_index], depot_index);
+
+    for (const Saving& saving : savings) {
+        int a = ending_at[saving.i], b = starting_at[saving.j];
+        if (a < 0 || b < 0 || a == b) continue;
+        if (built[a].load + built[b].load > capacity) continue;
+        Segment joined = concat_segments(segments[a], segments[b], distances);
+        if (!segment_feasible(concat_segments(concat_segments(depot_start, joined, distances), depot_end, distances))) continue;
+
+        ending_at[saving.i] = starting_at[saving.j] = -1;
+        ending_at[built[b].sequence.back()] = a;
+        built[a].sequence.insert(built[a].sequence.end(), built[b].sequence.begin(), built[b].sequence.end());
+        built[a].load += built[b].load;
+        built[b].sequence.clear();
+        segments[a] = joined;
+    }
+
+    remove_empty_routes(built);
+    for (auto& route : built) {
+        auto feasible_and_cost = route_feasible_and_cost(customers, depot_index, distances, route.sequence);
+        if (!feasible_and_cost.first) return false;
+        route.cost = feasible_and_cost.second;
+    }
+    routes.insert(routes.end(), built.begin(), built.end());
+    return true;
+}
+
+// everything solve() needs that depends only on the instance
+// the external matrix of the instance is shared, not copied
+std::shared_ptr<const DistanceMatrix> instance_distances(const Instance& instance, const CustomerTable& customers) {
+    if (instance.distances) return instance.distances;
+    return std::make_shared<const DistanceMatrix>(distance_matrix(customers));
+}
+
+struct PreparedInstance::Data {
+    Instance instance;
+    int neighbor_count;
+    CustomerTable customers;
+    // one of the two: a matrix, or coordinates in the matrix-free mode
+    std::shared_ptr<const DistanceMatrix> matrix;
+    std::unique_ptr<const CoordinateDistances> coordinates;
+    std::vector<std::vector<int>> neighbors;
+    TimeWindowCompatibility compatible;
+    LowerBounds bounds;
+
+    Data(Instance source, int neighbor_count, bool matrix_free)
+        : instance(std::move(source)), neighbor_count(neighbor_count), customers(instance.customers) {
+        if (matrix_free) {
+            coordinates.reset(new CoordinateDistances(customers));
+            prepare(*coordinates);
+        }
+        else {
+            matrix = instance_distances(instance, customers);
+            prepare(*matrix);
+        }
+    }
+
+    template <class Distance>
+    void prepare(const Distance& distances) {
+        neighbors = build_neighbor_lists(distances, 0, neighbor_count);
+        compatible = TimeWindowCompatibility(customers, 0, distances);
+        bounds = compute_lower_bounds(customers, 0, distances, instance.capacity, compatible, !instance.distances);
+    }
+};
+
+PreparedInstance::PreparedInstance(Instance instance, int neighbor_count, bool matrix_free) {
+    if (instance.customers.empty()) throw std::invalid_argument("Instance without depot.");
+    if (instance.distances && instance.distances->size() != instance.customers.size())
+        throw std::invalid_argument("Distance matrix size does not match the number of customers.");
+    if (instance.distances && matrix_free) throw std::invalid_argument("The matrix-free mode needs Euclidean distances, the instance has a matrix.");
+    impl = std::make_unique<Data>(std::move(instance), neighbor_count, matrix_free);
+}
+
+PreparedInstance::~PreparedInstance() = default;
+
+const Instance& PreparedInstance::instance() const { return impl->instance; }
+
+int PreparedInstance::neighbor_count() const { return impl->neighbor_count; }
+
+// Routes of a solution given by customer ids. Throws std::invalid_argument unless
+// every customer is visited exactly once and all routes are feasible.
+template <class Distance>
+std::vector<Route> routes_from_solution(const CustomerTable& customers, int depot_index,
+    const Distance& distances, double capacity, const Solution& solution) {
+    if (!solution.feasible) throw std::invalid_argument("Initial solution is marked infeasible.");
+    std::unordered_map<int, int> index_of;
+    for (int i = 0; i < (int)customers.size(); i++) if (i != depot_index) index_of[customers[i].id] = i;
+    std::vector<char> visited(customers.size(), 0);
+    std::vector<Route> routes;
+    for (auto& ids : solution.routes) {
+        Route r;
+        for (int id : ids) {
+            auto it = index_of.find(id);
+            if (it == index_of.end()) throw std::invalid_argument("Unknown customer " + std::to_string(id) + " in initial solution.");
+            if (visited[it->second]++) throw std::invalid_argument("Customer " + std::to_string(id) + " visited twice in initial solution.");
+            r.sequence.push_back(it->second);
+            r.load += customers[it->second].demand;
+        }
+        if (r.sequence.empty()) continue;
+        if (r.load > capacity) throw std::invalid_argument("Route " + std::to_string(routes.size() + 1) + " of initial solution exceeds capacity.");
+        auto fc = route_feasible_and_cost(customers, depot_index, distances, r.sequence);
+        if (!fc.first) throw std::invalid_argument("Route " + std::to_string(routes.size() + 1) + " of initial solution violates a time window.");
+        r.cost = fc.second;
+        routes.push_back(r);
+    }
+    for (int i = 0; i < (int)customers.size(); i++)
+        if (i != depot_index && !visited[i]) throw std::invalid_argument("Customer " + std::to_string(customers[i].id) + " missing from initial solution.");
+    return routes;
+}
+
+Solution Solver::solve(const Instance& instance) const {
+    if (instance.customers.empty()) return Solution();
+    return solve(PreparedInstance(instance, config.neighbor_count, config.matrix_free));
+}
+
+Solution Solver::solve(const Instance& instance, const Solution& initial) const {
+    if (instance.customers.empty()) return Solution();
+    return solve(PreparedInstance(instance, config.neighbor_count, config.matrix_free), initial);
+}
+
+Solution Solver::solve(const PreparedInstance& prepared) const {
+    return solve_from(prepared, nullptr);
+}
+
+Solution Solver::solve(const PreparedInstance& prepared, const Solution& initial) const {
+    return solve_from(prepared, &initial);
+}
+
+Solution Solver::solve_from(const PreparedInstance& prepared, const Solution* initial) const {
+    if (prepared.impl->coordinates) return solve_with(prepared, *prepared.impl->coordinates, initial);
+    return solve_with(prepared, *prepared.impl->matrix, initial);
+}
+
+template <class Distance>
+Solution Solver::solve_with(const PreparedInstance& prepared, const Distance& distances, const Solution* initial) const {
+    const Instance& instance = prepared.instance();
+    auto solve_start = std::chrono::steady_clock::now();
+    auto seconds = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - solve_start).count(); };
+    std::mutex progress_mutex;
+    auto report = [&](const std::string& phase, const std::string& message, double cost, int routes, long long iterations) {
+        if (!progress) return;
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        progress({ phase, message, seconds(), cost, routes, iterations });
+    };
+    auto note = [&](const std::string& phase, const std::string& message) { report(phase, message, 0.0, 0, 0); };
+
+    const CustomerTable& customers = prepared.impl->customers;
+    double capacity = instance.capacity;
+    int n = customers.size();
+    int depot_index = 0;
+    Solution solution;
+
+    // Demand feasibility
+    for (int i = 1; i < n; i++)
+        if (customers[i].demand > capacity) return solution;
+
+    const std::vector<std::vector<int>>& neighbors = prepared.impl->neighbors;
+    const TimeWindowCompatibility& compatible = prepared.impl->compatible;
+    long long compatible_pairs = 0;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) compatible_pairs += compatible.can_follow(i, j);
+    note("bounds", "Time-window compatible pairs: " + format_cost(std::round(1000.0 * compatible_pairs / ((double)n * n)) / 10.0) + "%");
+    const LowerBounds& bounds = prepared.impl->bounds;
+    solution.lower_bound = bounds.cost;
+    solution.vehicle_lower_bound = bounds.vehicles();
+    note("bounds", "Lower bounds: vehicles >= " + std::to_string(bounds.vehicles()) + " (capacity " + std::to_string(bounds.capacity_vehicles)
+        + ", time windows " + std::to_string(bounds.time_window_vehicles) + "), cost >= " + format_cost(bounds.cost));
+
+    std::vector<Route> routes;
+    double total_cost;
+    std::unique_ptr<TabuCheckpoint> checkpoint;
+    if ((config.resume || !config.checkpoint_path.empty())
+        && (config.solver != "tabu" || config.islands > 1 || !config.decompose.empty()))
+        throw std::invalid_argument("Checkpoints are supported for the single tabu search only.");
+    if (config.resume) {
+        checkpoint.reset(new TabuCheckpoint(TabuCheckpoint::load(config.checkpoint_path)));
+        if (checkpoint->instance_hash != instance.hash()) throw std::invalid_argument("Checkpoint " + config.checkpoint_path + " belongs to another instance.");
+        for (auto& sequence : checkpoint->best) {
+            Route r;
+            r.sequence = sequence;
+            for (int c : sequence) r.load += customers[c].demand;
+            routes.push_back(r);
+        }
+        total_cost = checkpoint->best_cost;
+        report("construction", "Resumed from checkpoint at " + format_cost(std::round(checkpoint->elapsed)) + " s, iteration "
+            + std::to_string(checkpoint->iterations) + ". Cost: " + format_cost(total_cost), total_cost, routes.size(), checkpoint->iterations);
+    }
+    else if (initial) {
+        // start from a given solution instead of the construction
+        routes = routes_from_solution(customers, depot_index, distances, capacity, *initial);
+        total_cost = totalCostCount(routes, customers, distances);
+        if (std::fabs(total_cost - initial->cost) > 1e-3 * std::max(1.0, total_cost))
+            note("construction", "Initial solution cost " + format_cost(initial->cost) + " recomputed as " + format_cost(total_cost));
+        report("construction", "Initial solution loaded. Routes: " + std::to_string(routes.size()) + ", Cost: " + format_cost(total_cost)
+            + ", gap: " + format_cost(std::round(100.0 * gap_percent(total_cost, bounds)) / 100.0) + "%", total_cost, routes.size(), 0);
+    }
+    else if (config.construction == "savings") {
+        note("construction", "Starting Clarke-Wright savings construction...");
+        auto savings_start = std::chrono::high_resolution_clock::now();
+        if (!savings_construction(customers, depot_index, distances, capacity, routes)) return solution;
+        total_cost = totalCostCount(routes, customers, distances);
+        auto savings_duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - savings_start);
+        note("construction", "savings, microseconds: " + std::to_string(savings_duration.count()));
+        report("construction", "Savings initial solution found. Routes: " + std::to_string(routes.size()) + ", Cost: " + format_cost(total_cost)
+            + ", gap: " + format_cost(std::round(100.0 * gap_percent(total_cost, bounds)) / 100.0) + "%", total_cost, routes.size(), 0);
+    }
+    else {
+        // --- POCZĄTEK HEURYSTYKI ZACHŁANNEJ (GREEDY) ---
+        note("construction", "Starting Greedy Heuristic construction...");
+        auto greedy_start = std::chrono::high_resolution_clock::now();
+        if (!greedy_construction(customers, depot_index, distances, capacity, routes)) return solution;
+        total_cost = totalCostCount(routes, customers, distances);
+        auto greedy_duration_ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - greedy_start);
+        note("construction", "greedy, nanoseconds: " + std::to_string(greedy_duration_ns.count()));
+        report("construction", "Greedy initial solution found. Routes: " + std::to_string(routes.size()) + ", Cost: " + format_cost(total_cost)
+            + ", gap: " + format_cost(std::round(100.0 * gap_percent(total_cost, bounds)) / 100.0) + "%", total_cost, routes.size(), 0);
+        // --- KONIEC HEURYSTYKI ZACHŁANNEJ ---
+    }
+
+    ProblemData<Distance> data{ customers, depot_index, distances, capacity, neighbors, compatible, !instance.distances };
+
+    // redukcja liczby pojazdów
+    if (config.fleet_seconds > 0 && !checkpoint) {
+        int min_routes = bounds.vehicles();
+        int before = routes.size();
+        auto fleet_start = std::chrono::steady_clock::now();
+        // fleet reduction is part of the time limit
+        double fleet_seconds = std::max(0.0, std::min(config.fleet_seconds, config.time_limit - seconds()));
+        reduce_fleet(data, routes, min_routes, fleet_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(fleet_seconds)), config.seed);
+        total_cost = totalCostCount(routes, customers, distances);
+        report("fleet", "Fleet reduction: " + std::to_string(before) + " -> " + std::to_string(routes.size()) + " routes (vehicles: "
+            + std::to_string(instance.vehicles) + ", lower bound: " + std::to_string(min_routes) + "), Cost: " + format_cost(total_cost) + ", "
+            + format_cost(std::chrono::duration<double>(std::chrono::steady_clock::now() - fleet_start).count()) + " s", total_cost, routes.size(), 0);
+    }
+
+    // --- POCZĄTEK TABU SEARCH ---
+    TabuParams params;
+    params.cross_max_len = config.cross_max_len;
+    params.exchange_every = config.exchange_every;
+    params.seed = config.seed;
+    params.penalty_mode = config.penalty_mode;
+    params.target_cost = bounds.cost * (1.0 + config.target_gap / 100.0);
+    ExactRouteCache exact_cache;
+    if (config.exact_routes) params.exact_cache = &exact_cache;
+    RoutePool pool;
+    if (config.use_pool) {
+        if (checkpoint)
+            for (auto& e : checkpoint->pool) pool.add(depot_index, e.sequence, e.cost);
+        else {
+            for (auto& r : routes) pool.add(depot_index, r.sequence, route_feasible_and_cost(customers, depot_index, distances, r.sequence).second);
+            // savings routes join differently from greedy and tabu ones; over neighbor pairs
+            // only, the initial routes already are savings routes when that construction ran
+            std::vector<Route> savings_routes;
+            if (config.construction != "savings" && savings_construction(customers, depot_index, distances, capacity, savings_routes, &neighbors))
+                for (auto& r : savings_routes) pool.add(depot_index, r.sequence, r.cost);
+        }
+        params.pool = &pool;
+    }
+    double time_limit = config.time_limit;
+    if (!config.checkpoint_path.empty()) {
+        params.checkpoint_path = config.checkpoint_path;
+        params.checkpoint_every = config.checkpoint_seconds;
+        params.instance_hash = instance.hash();
+    }
+    if (checkpoint) {
+        // the time limit covers the interrupted run too
+        params.resume = checkpoint.get();
+        params.elapsed_before = checkpoint->elapsed;
+        time_limit = std::max(0.0, time_limit - checkpoint->elapsed);
+    }
+    params.deadline = solve_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_limit));
+    // only strictly better solutions are reported, islands may find them concurrently
+    double reported_cost = total_cost;
+    double published_cost = std::numeric_limits<double>::infinity();
+    std::unique_ptr<SolutionWriter> writer;
+    if (solution_callback) {
+        writer.reset(new SolutionWriter([&](const SolutionSnapshot& snapshot) {
+            // islands may post out of order, only improvements go out
+            if (snapshot.cost >= published_cost) return;
+            published_cost = snapshot.cost;
+            Solution best;
+            best.feasible = true;
+            best.cost = snapshot.cost;
+            for (auto& sequence : snapshot.routes) {
+                std::vector<int> ids;
+                for (int index : sequence) ids.push_back(customers[index].id);
+                best.routes.push_back(ids);
+            }
+            best.lower_bound = bounds.cost;
+            best.vehicle_lower_bound = bounds.vehicles();
+            best.iterations = snapshot.iteration;
+            best.seconds = snapshot.seconds;
+            solution_callback(best);
+        }));
+        writer->post(solution_snapshot(routes, total_cost, 0, seconds()));
+    }
+    params.on_improvement = [&](const std::vector<Route>& best, double cost, long long iteration) {
+        if (writer) writer->post(solution_snapshot(best, cost, iteration, seconds()));
+        if (!progress) return;
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        if (cost >= reported_cost) return;
+        reported_cost = cost;
+        progress({ "improvement", "", seconds(), cost, (int)best.size(), iteration });
+    };
+
+    auto tabu_start = std::chrono::high_resolution_clock::now();
+    int threads = std::max(1, config.threads);
+    TabuResult tabu;
+    if (config.solver == "alns") {
+        note("search", "Starting ALNS...");
+        AlnsParams alns_params;
+        alns_params.max_iterations = config.alns_iterations;
+        alns_params.seed = config.seed;
+        alns_params.target_cost = params.target_cost;
+        alns_params.on_improvement = params.on_improvement;
+        alns_params.deadline = params.deadline;
+        tabu = alns_search(data, routes, alns_params);
+    }
+    else if (config.solver == "hgs") {
+        note("search", "Starting hybrid genetic search...");
+        HgsParams hgs_params;
+        hgs_params.threads = threads;
+        hgs_params.cross_max_len = config.cross_max_len;
+        hgs_params.seed = config.seed;
+        hgs_params.target_cost = params.target_cost;
+        hgs_params.on_improvement = params.on_improvement;
+        hgs_params.deadline = params.deadline;
+        tabu = hgs_search(data, routes, hgs_params);
+    }
+    else if (!config.decompose.empty()) {
+        int sectors = config.sectors > 0 ? config.sectors : threads;
+        note("search", "Starting decomposition search (" + std::to_string(sectors) + " sectors, " + config.decompose + ")...");
+        tabu = decomposition_search(data, routes, params, sectors, threads, config.decompose == "kmeans");
+        note("search", "Rounds: " + std::to_string(tabu.restarts));
+    }
+    else {
+        note("search", "Starting Tabu Search...");
+        tabu = config.islands > 1 ? island_search(data, routes, total_cost, params, config.islands) : tabu_search(data, routes, params);
+    }
+    for (auto& line : tabu.notes) note("note", line);
+    std::vector<Route> best_solution = tabu.best_solution;
+    double best_cost = tabu.best_cost;
+
+    auto tabu_duration_ns = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - tabu_start);
+    note("search", "tabu, nanoseconds: " + std::to_string(tabu_duration_ns.count()));
+    report("search", "Iterations: " + std::to_string(tabu.iterations), best_cost, best_solution.size(), tabu.iterations);
+    if (config.solver == "tabu" && config.decompose.empty())
+        note("search", "Escapes: " + std::to_string(tabu.escapes) + ", final tenure: " + std::to_string(tabu.final_tenure));
+    // remove any empty routes
+    remove_empty_routes(best_solution);
+    if (config.use_pool) {
+        for (auto& r : best_solution) pool.add(depot_index, r.sequence, route_feasible_and_cost(customers, depot_index, distances, r.sequence).second);
+        std::mt19937 pool_rng(config.seed);
+        bool improved = recombine_pool(data, pool, best_solution, best_cost, pool_rng, 50);
+        report("pool", "Route pool: " + std::to_string(pool.size()) + " routes, recombinations: " + std::to_string(tabu.recombinations + improved)
+            + ", Cost: " + format_cost(best_cost), best_cost, best_solution.size(), tabu.iterations);
+    }
+    if (config.exact_routes) {
+        int improved = optimize_short_routes(data, best_solution, exact_cache, threads);
+        best_cost = totalCostCount(best_solution, customers, distances);
+        report("exact", "Exact short-route re-optimization: " + std::to_string(improved) + " routes improved, Cost: " + format_cost(best_cost),
+            best_cost, best_solution.size(), tabu.iterations);
+    }
+
+    solution.feasible = true;
+    solution.cost = totalCostCount(best_solution, customers, distances);
+    for (auto& r : best_solution) {
+        std::vector<int> ids;
+        for (int index : r.sequence) ids.push_back(customers[index].id);
+        solution.routes.push_back(ids);
+    }
+    solution.iterations = tabu.iterations;
+    solution.seconds = seconds();
+    if (writer) {
+        writer->post(solution_snapshot(best_solution, solution.cost, tabu.iterations, solution.seconds));
+        writer->stop();
+    }
+    return solution;
+}
+
+
+// --- PRZEPLANOWANIE ---
+
+struct Replanner::State {
+    CustomerTable customers;
+    double capacity;
+    int vehicles;
+    int neighbor_count;
+    DistanceMatrix distances;
+    std::vector<std::vector<int>> neighbors;
+    TimeWindowCompatibility compatible;
+    std::unordered_map<int, int> index_of;   // customer id -> index
+    SearchState search;
+    std::vector<int> pending;                // indexes waiting for insertion
+    std::vector<int> unserved;               // ids that fit nowhere, not even alone
+    unsigned improve_calls = 0;              // seeds of the improve() searches
+
+    State(const Instance& instance, int neighbor_count)
+        : customers(instance.customers), capacity(instance.capacity), vehicles(instance.vehicles), neighbor_count(neighbor_count),
+        distances(distance_matrix(customers)), neighbors(build_neighbor_lists(distances, 0, neighbor_count)),
+        compatible(customers, 0, distances) {
+        for (int i = 0; i < (int)customers.size(); i++) index_of[customers[i].id] = i;
+    }
+
+    ProblemData<DistanceMatrix> data() const { return { customers, 0, distances, capacity, neighbors, compatible }; }
+
+    // row, column, neighbor lists and compatibility of customer i, O(n * k)
+    void refresh_customer(int i) {
+        int n = customers.size();
+        if ((int)distances.size() < n) {
+            distances.resize(n);
+            neighbors.emplace_back();
+        }
+        for (int j = 0; j < n; j++) distances[i][j] = distances[j][i] = euclidean_distance(customers[i], customers[j]);
+        compatible.update(customers, 0, distances, i);
+
+        auto closer = [&](int from) { return [&, from](int a, int b) { return distances[from][a] < distances[from][b]; }; };
+        std::vector<int> order;
+        for (int j = 1; j < n; j++) {
+            if (j == i || !index_of.count(customers[j].id) || index_of[customers[j].id] != j) continue;
+            order.push_back(j);
+            // i enters the list of j when closer than its farthest neighbor
+            std::vector<int>& list = neighbors[j];
+            list.erase(std::remove(list.begin(), list.end(), i), list.end());
+            if ((int)list.size() < neighbor_count || distances[j][i] < distances[j][list.back()]) {
+                list.insert(std::upper_bound(list.begin(), list.end(), i, closer(j)), i);
+                if ((int)list.size() > neighbor_count) list.pop_back();
+            }
+        }
+        int take = std::min<int>(neighbor_count, order.size());
+        std::partial_sort(order.begin(), order.begin() + take, order.end(), closer(i));
+        neighbors[i].assign(order.begin(), order.begin() + take);
+    }
+
+    // removals, changes and additions, then the cheapest feasible insertion of the
+    // pending customers (a new route when nothing fits); returns the changed routes
+    std::vector<int> update(const CustomerDelta& delta) {
+        for (int id : delta.removed) {
+            auto it = index_of.find(id);
+            if (it == index_of.end() || it->second == 0) continue;
+            unroute(it->second);
+            pending.erase(std::remove(pending.begin(), pending.end(), it->second), pending.end());
+            // the index stays allocated, only the id mapping is dropped
+            index_of.erase(it);
+        }
+        for (const Customer& c : delta.modified) {
+            auto it = index_of.find(c.id);
+            if (it == index_of.end()) continue;
+            if (it->second == 0) throw std::invalid_argument("The depot cannot be modified.");
+            int i = it->second;
+            unroute(i);
+            bool moved = customers[i].x != c.x || customers[i].y != c.y;
+            customers.set(i, c);
+            if (moved) refresh_customer(i);
+            else compatible.update(customers, 0, distances, i);
+            if (std::find(pending.begin(), pending.end(), i) == pending.end()) pending.push_back(i);
+        }
+        for (const Customer& c : delta.added) {
+            if (index_of.count(c.id)) throw std::invalid_argument("Customer " + std::to_string(c.id) + " already exists.");
+            int i = customers.size();
+            customers.push_back(c);
+            index_of[c.id] = i;
+            refresh_customer(i);
+            pending.push_back(i);
+        }
+
+        // cheapest feasible insertion, a new route when nothing fits
+        ProblemData<DistanceMatrix> problem = data();
+        refresh_all_routes(problem, search);
+        std::vector<int> focus;
+        unserved.clear();
+        for (int u : pending) {
+            InsertionOption best;
+            if (customers[u].demand <= capacity)
+                for (int r = 0; r < (int)search.routes.size(); r++) {
+                    InsertionOption option = best_insertion(problem, search, u, r);
+                    if (option.delta < best.delta) best = option;
+                }
+            if (best.route >= 0) {
+                std::vector<int>& seq = search.routes[best.route].sequence;
+                seq.insert(seq.begin() + best.position, u);
+                search.routes[best.route].load += customers[u].demand;
+                refresh_route(problem, search, best.route);
+                if (std::find(focus.begin(), focus.end(), best.route) == focus.end()) focus.push_back(best.route);
+            }
+            else if (customers[u].demand <= capacity && route_feasible_and_cost(customers, 0, distances, { u }).first) {
+                Route r;
+                r.sequence = { u };
+                r.load = customers[u].demand;
+                search.routes.push_back(r);
+                search.segments.emplace_back();
+                refresh_route(problem, search, search.routes.size() - 1);
+                focus.push_back(search.routes.size() - 1);
+            }
+            else unserved.push_back(customers[u].id);
+        }
+        pending.clear();
+        for (int id : unserved) pending.push_back(index_of[id]);
+        return focus;
+    }
+
+    Solution plan(const std::vector<Route>& routes) const {
+        Solution result;
+        result.feasible = unserved.empty();
+        for (auto& r : routes) {
+            if (r.sequence.empty()) continue;
+            std::vector<int> ids;
+            for (int index : r.sequence) ids.push_back(customers[index].id);
+            result.routes.push_back(ids);
+            result.cost += route_feasible_and_cost(customers, 0, distances, r.sequence).second;
+        }
+        return result;
+    }
+
+    void unroute(int i) {
+        for (auto& r : search.routes) {
+            auto it = std::find(r.sequence.begin(), r.sequence.end(), i);
+            if (it == r.sequence.end()) continue;
+            r.sequence.erase(it);
+            r.load -= customers[i].demand;
+        }
+        remove_empty_routes(search.routes);
+    }
+};
+
+Replanner::Replanner(const Instance& instance, const Solution& solution, SolverConfig config)
+    : config(std::move(config)) {
+    if (instance.customers.empty()) throw std::invalid_argument("Instance without depot.");
+    if (instance.distances) throw std::invalid_argument("Re-planning needs Euclidean distances, the instance has an external matrix.");
+    impl = std::make_unique<State>(instance, this->config.neighbor_count);
+    State& st = *impl;
+    std::vector<char> routed(st.customers.size(), 0);
+    for (auto& ids : solution.routes) {
+        Route r;
+        for (int id : ids) {
+            auto it = st.index_of.find(id);
+            if (it == st.index_of.end() || it->second == 0 || routed[it->second]) throw std::invalid_argument("Unknown or repeated customer " + std::to_string(id) + " in solution.");
+            routed[it->second] = 1;
+            r.sequence.push_back(it->second);
+            r.load += st.customers[it->second].demand;
+        }
+        if (!r.sequence.empty()) st.search.routes.push_back(r);
+    }
+    for (int i = 1; i < (int)st.customers.size(); i++)
+        if (!routed[i]) st.pending.push_back(i);
+    refresh_all_routes(st.data(), st.search);
+}
+
+Replanner::~Replanner() = default;
+
+Solution Replanner::apply(const CustomerDelta& delta, double seconds) {
+    auto started = std::chrono::steady_clock::now();
+    State& st = *impl;
+    std::vector<int> focus = st.update(delta);
+    auto deadline = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    focused_descent(st.data(), st.search, focus, config.cross_max_len, deadline);
+    return solution();
+}
+
+bool Replanner::improve(double seconds) {
+    State& st = *impl;
+    if (st.search.routes.empty()) return false;
+    ProblemData<DistanceMatrix> data = st.data();
+    TabuParams params;
+    params.cross_max_len = config.cross_max_len;
+    params.seed = config.seed + st.improve_calls++;
+    params.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    double cost = 0.0;
+    for (auto& r : st.search.routes) cost += r.cost;
+    TabuResult result = tabu_search(data, st.search.routes, params);
+    if (result.best_cost >= cost - 1e-9) return false;
+    st.search.routes = result.best_solution;
+    remove_empty_routes(st.search.routes);
+    refresh_all_routes(data, st.search);
+    return true;
+}
+
+Solution Replanner::search(double seconds, const std::function<CustomerDelta(bool idle)>& poll,
+    const std::function<void(const Solution&)>& on_change) {
+    State& st = *impl;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    // the delta goes into the given routes, which are the current ones of the search
+    auto take = [&](std::vector<Route>& routes, bool idle) {
+        CustomerDelta delta = poll(idle);
+        if (delta.added.empty() && delta.removed.empty() && delta.modified.empty()) return false;
+        st.search.routes = routes;
+        st.update(delta);
+        routes = st.search.routes;
+        on_change(solution());
+        return true;
+    };
+    ProblemData<DistanceMatrix> data = st.data();
+    TabuParams params;
+    params.cross_max_len = config.cross_max_len;
+    params.deadline = deadline;
+    params.arrivals = take;
+    params.on_improvement = [&](const std::vector<Route>& routes, double, long long) { on_change(st.plan(routes)); };
+    do {
+        // nothing to search yet, or everything was removed meanwhile
+        while (st.search.routes.empty())
+            if (std::chrono::steady_clock::now() >= deadline || !take(st.search.routes, true)) return solution();
+        params.seed = config.seed + st.improve_calls++;
+        TabuResult result = tabu_search(data, st.search.routes, params);
+        st.search.routes = result.best_solution;
+        remove_empty_routes(st.search.routes);
+        refresh_all_routes(data, st.search);
+    } while (st.search.routes.empty() && std::chrono::steady_clock::now() < deadline);
+    return solution();
+}
+
+Solution Replanner::solution() const { return impl->plan(impl->search.routes); }
+
+const std::vector<int>& Replanner::unserved() const { return impl->unserved; }
+
+Instance Replanner::instance() const {
+    const State& st = *impl;
+    Instance result;
+    result.vehicles = st.vehicles;
+    result.capacity = st.capacity;
+    result.customers.push_back(st.customers[0]);
+    for (int i = 1; i < (int)st.customers.size(); i++) {
+        auto it = st.index_of.find(st.customers[i].id);
+        if (it != st.index_of.end() && it->second == i) result.customers.push_back(st.customers[i]);
+    }
+    return result;
+}
+
+} // namespace cvrptw
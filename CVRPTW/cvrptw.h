@@ -0,0 +1,291 @@
+#ifndef CVRPTW_H
+#define CVRPTW_H
+
+// Solver CVRPTW jako biblioteka: instancja w pamięci albo z pliku, konfiguracja,
+// rozwiązanie jako obiekt i postęp przez callback. Program merged.cpp jest tylko
+// nakładką na to API (budowanie: g++ -std=c++17 -pthread merged.cpp cvrptw.cpp).
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cvrptw {
+
+struct Customer {
+    int id;
+    double x, y;
+    int demand;
+    double ready, due, service;
+    Customer(int id, double x, double y, int demand, double ready, double due, double service)
+        : id(id), x(x), y(y), demand(demand), ready(ready), due(due), service(service) {
+    }
+};
+
+// n x n travel times, row = from and column = to in the order of
+// Instance::customers; may be asymmetric and need not follow the coordinates.
+// Either owned, or a read-only memory map of a file: the pages are shared with
+// every other process mapping the same file and never copied to the heap.
+class DistanceMatrix {
+public:
+    DistanceMatrix() = default;
+    explicit DistanceMatrix(size_t n);    // owned, zero-filled
+    ~DistanceMatrix();
+    DistanceMatrix(DistanceMatrix&& other) noexcept;
+    DistanceMatrix& operator=(DistanceMatrix&& other) noexcept;
+    DistanceMatrix(const DistanceMatrix&) = delete;
+    DistanceMatrix& operator=(const DistanceMatrix&) = delete;
+
+    // n * n doubles, row-major, native byte order; throws std::runtime_error when
+    // the file cannot be mapped or does not hold exactly n * n values
+    static DistanceMatrix map_file(const std::string& path, size_t n);
+    // the same values as whitespace separated text, read into an owned matrix
+    static DistanceMatrix read_text(const std::string& path, size_t n);
+
+    size_t size() const { return n; }
+    const double* operator[](size_t i) const { return values + i * stride; }
+    // owned matrices only, a mapped one is read-only
+    double* operator[](size_t i) { return values + i * stride; }
+    bool mapped() const { return mapping != nullptr; }
+    // owned only: grows to n x n with zeros, storage grows geometrically so adding
+    // rows one by one is amortized O(n) each
+    void resize(size_t n);
+    // content hash, reads the whole matrix
+    uint64_t hash() const;
+
+private:
+    size_t n = 0, stride = 0;
+    double* values = nullptr;
+    std::vector<double> owned;
+    void* mapping = nullptr;
+    size_t mapped_bytes = 0;
+};
+
+// customers[0] is the depot, ids are the ones reported in Solution::routes
+struct Instance {
+    std::vector<Customer> customers;
+    int vehicles = 0;
+    double capacity = 0.0;
+    // external travel times; nullptr: Euclidean distances of the coordinates
+    std::shared_ptr<const DistanceMatrix> distances;
+
+    // Solomon text format; throws std::runtime_error when the file cannot be read
+    // or has no customers
+    static Instance from_file(const std::string& path);
+    static Instance parse(std::istream& in);
+
+    // content hash, equal instances give equal hashes
+    uint64_t hash() const;
+};
+
+// Instance with its distance matrix, neighbor lists, time-window compatibility and
+// lower bounds built once, so repeated solves skip the O(n^2) preprocessing.
+// Immutable after construction and safe to share between threads.
+// matrix_free keeps only the coordinates and the neighbor lists and computes
+// distances when needed, for instances too big for an n x n matrix (the
+// time-window compatibility still takes n^2 bits); not with an external matrix
+// (std::invalid_argument).
+class PreparedInstance {
+public:
+    explicit PreparedInstance(Instance instance, int neighbor_count = 20, bool matrix_free = false);
+    ~PreparedInstance();
+    PreparedInstance(const PreparedInstance&) = delete;
+    PreparedInstance& operator=(const PreparedInstance&) = delete;
+
+    const Instance& instance() const;
+    int neighbor_count() const;
+
+private:
+    friend class Solver;
+    struct Data;
+    std::unique_ptr<Data> impl;
+};
+
+// the command-line options of merged.cpp
+struct SolverConfig {
+    std::string solver = "tabu";     // tabu, alns or hgs
+    std::string construction = "greedy";   // greedy or savings (Clarke-Wright)
+    double time_limit = 299.0;       // seconds for the whole solve()
+    unsigned seed = 1;
+    int cross_max_len = 3;
+    int neighbor_count = 20;
+    int islands = 1;
+    int exchange_every = 100;
+    bool penalty_mode = false;
+    int alns_iterations = 5000;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    double fleet_seconds = 10.0;     // upper limit; 0 disables fleet reduction, capped by time_limit
+    bool exact_routes = true;
+    bool use_pool = true;
+    std::string decompose;           // "", angle or kmeans
+    int sectors = 0;                 // 0: one per thread
+    // stop at this percent above the cost lower bound. The bound ignores waiting and
+    // time-window detours: on Solomon it is 5% (C1) to 40% (R1, R2) below good
+    // solutions, on m2kvrptw-0 about 4%, so small gaps are often never reached
+    double target_gap = 0.0;
+    bool matrix_free = false;        // see PreparedInstance, for solve(Instance)
+    // single tabu search only: state written every checkpoint_seconds, replaced
+    // atomically; resume continues the run stored there (std::invalid_argument when
+    // it belongs to another instance or another solver is selected,
+    // std::runtime_error when unreadable)
+    std::string checkpoint_path;
+    double checkpoint_seconds = 30.0;
+    bool resume = false;
+};
+
+struct Progress {
+    // bounds, construction, fleet, search, improvement, pool, exact or note
+    std::string phase;
+    std::string message;             // human readable, empty for improvements
+    double seconds = 0.0;            // since solve() started
+    double best_cost = 0.0;
+    int routes = 0;
+    long long iterations = 0;
+};
+
+using ProgressCallback = std::function<void(const Progress&)>;
+
+struct Solution {
+    bool feasible = false;
+    std::vector<std::vector<int>> routes;  // customer ids in visiting order
+    double cost = 0.0;
+    double lower_bound = 0.0;
+    int vehicle_lower_bound = 0;
+    long long iterations = 0;
+    double seconds = 0.0;
+
+    double gap_percent() const;
+    // the wynik.txt format: "routes cost" then one line of ids per route, -1 if infeasible
+    void write(std::ostream& out) const;
+    // the same, written to path.tmp and renamed over path; throws std::runtime_error
+    void save(const std::string& path) const;
+    // reads the same format back (only routes and cost); throws std::runtime_error
+    static Solution parse(std::istream& in);
+    static Solution from_file(const std::string& path);
+};
+
+class Solver {
+public:
+    explicit Solver(SolverConfig config = SolverConfig()) : config(std::move(config)) {}
+
+    // called from the solving thread, improvements may also come from island threads
+    // (calls are serialized)
+    void on_progress(ProgressCallback callback) { progress = std::move(callback); }
+    // every new best solution (seconds and iterations at the time it was found), from
+    // a background thread so the search never waits for it; a slow callback skips
+    // the solutions superseded in the meantime, the last one is always delivered
+    // before solve() returns
+    void on_solution(std::function<void(const Solution&)> callback) { solution_callback = std::move(callback); }
+
+    Solution solve(const Instance& instance) const;
+    // neighbor lists of the prepared instance are used, config.neighbor_count is ignored
+    Solution solve(const PreparedInstance& prepared) const;
+    // warm start: the construction is skipped and the search starts from initial,
+    // which must visit every customer once with feasible routes (std::invalid_argument)
+    Solution solve(const Instance& instance, const Solution& initial) const;
+    Solution solve(const PreparedInstance& prepared, const Solution& initial) const;
+
+private:
+    Solution solve_from(const PreparedInstance& prepared, const Solution* initial) const;
+    // Distance: DistanceMatrix or the matrix-free provider, defined in cvrptw.cpp
+    template <class Distance>
+    Solution solve_with(const PreparedInstance& prepared, const Distance& distances, const Solution* initial) const;
+
+    SolverConfig config;
+    ProgressCallback progress;
+    std::function<void(const Solution&)> solution_callback;
+};
+
+struct CustomerDelta {
+    std::vector<Customer> added;      // ids not in the plan yet
+    std::vector<Customer> modified;   // existing ids with new data
+    std::vector<int> removed;         // ids
+};
+
+// Live plan updated by customer changes without re-running the whole pipeline.
+// The distance matrix, neighbor lists and time-window compatibility are extended in
+// O(n) per new customer; changed customers are reinserted by cheapest feasible
+// insertion and the touched routes improved by a short local search.
+class Replanner {
+public:
+    // solution routes use customer ids of the instance, missing customers are
+    // inserted by the first apply(); throws std::invalid_argument on unknown ids
+    // and for instances with an external matrix (new customers need coordinates)
+    Replanner(const Instance& instance, const Solution& solution, SolverConfig config = SolverConfig());
+    ~Replanner();
+    Replanner(const Replanner&) = delete;
+    Replanner& operator=(const Replanner&) = delete;
+
+    // seconds bounds the whole call, repair included
+    Solution apply(const CustomerDelta& delta, double seconds = 0.04);
+    // tabu search on the whole plan for the given time, kept only when it is cheaper;
+    // returns whether the plan improved
+    bool improve(double seconds);
+    // one tabu search for up to seconds that takes changes from poll() between its
+    // iterations instead of restarting. idle: the search stalled, poll may wait for
+    // changes and an empty delta ends the search. on_change gets the plan after each
+    // delta and each new best plan.
+    Solution search(double seconds, const std::function<CustomerDelta(bool idle)>& poll,
+        const std::function<void(const Solution&)>& on_change);
+    Solution solution() const;
+    // customers that fit no route, not even alone; kept and retried by the next apply()
+    const std::vector<int>& unserved() const;
+    // the current customers, for a full re-solve
+    Instance instance() const;
+
+private:
+    struct State;
+    SolverConfig config;
+    std::unique_ptr<State> impl;
+};
+
+// Customers handed from a reader thread to the solving loop of the online mode.
+// push() never blocks and may be called from several threads; drain() (a single
+// consumer) takes everything pushed so far, in arrival order.
+class CustomerQueue {
+public:
+    CustomerQueue() = default;
+    CustomerQueue(const CustomerQueue&) = delete;
+    CustomerQueue& operator=(const CustomerQueue&) = delete;
+    ~CustomerQueue() { drain(); }
+
+    void push(const Customer& customer) {
+        Node* node = new Node{ customer, head.load(std::memory_order_relaxed) };
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    std::vector<Customer> drain() {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        std::vector<Customer> customers;
+        while (node) {
+            customers.push_back(node->customer);
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        std::reverse(customers.begin(), customers.end());
+        return customers;
+    }
+
+    // no more customers after the ones already pushed
+    void close() { closed.store(true, std::memory_order_release); }
+    bool is_closed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+    struct Node {
+        Customer customer;
+        Node* next;
+    };
+    std::atomic<Node*> head{ nullptr };
+    std::atomic<bool> closed{ false };
+};
+
+} // namespace cvrptw
+
+#endif
@@ -2,311 +2,68 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <cmath>
-#include <utility>
-#include <algorithm>
-#include <iomanip>
-#include <limits>
 #include <chrono>
-#include <filesystem> // <-- POPRAWKA 1: Dodany include
+#include <stdexcept>
+#include <filesystem>
 
-// Definicja aliasu dla filesystem
-namespace fs = std::filesystem;
-
-struct Customer
-{
-    int id;
-    double x, y;
-    int demand;
-    double ready, due, service;
-    Customer(int id, double x, double y, int demand, double ready, double due, double service) : id(id), x(x), y(y), demand(demand), ready(ready), due(due), service(service) {}
-};
-struct Route
-{
-    std::vector<int> sequence;
-    int load = 0;
-    double cost = 0.0;
-};
-double euclidean_distance(const Customer &a, const Customer &b)
-{
-    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
-}
-
-std::pair<bool, double> route_feasible_and_cost(const std::vector<Customer> &customers, int depot_index, const std::vector<std::vector<double>> &distance, const std::vector<int> &route_indexes)
-{
-    double time = 0.0;
-    double cost = 0.0;
-    int prev = depot_index;
-    const Customer &depot = customers[depot_index];
-
-    for (int index : route_indexes)
-    {
-        const Customer &customer = customers[index];
-        double travel = distance[prev][index];
-
-        cost += travel;
-        time = time + travel;
-
-        // pracownik był za wcześnie
-        double wait_time = 0.0;
-        if (time < customer.ready)
-        {
-            wait_time = customer.ready - time;
-            time = customer.ready;
-        }
-
-        // pracownik nie zdążył
-        if (time > customer.due)
-        {
-            return {false, 0.0};
-        }
+#include "cvrptw.h"
 
-        // Obliczanie czasu i kosztu po wykonanej usłudze
-        cost += wait_time;
-        cost += customer.service;
-        time += customer.service;
-
-        prev = index;
-    }
-
-    // powrót do depotu
-    double travel_to_depot = distance[prev][depot_index];
-    cost += travel_to_depot;
-    time += travel_to_depot;
-
-    if (time > depot.due)
-    {
-        return {false, 0.0};
-    }
-
-    return {true, cost};
-}
+namespace fs = std::filesystem;
 
-int main(int argc, char **argv)
+// Przetwarzanie wsadowe: każda instancja z katalogu (domyślnie ./solomon_100)
+// rozwiązana osobno, wynik zapisany do wynik_<plik>. Bez --time bez przeszukiwania,
+// tylko konstrukcja startowa jak dawniej; "-1" gdy instancji nie da się rozwiązać.
+// budowanie: g++ -O2 -std=c++17 -pthread greedy_copy.cpp cvrptw.cpp
+int main(int argc, char** argv)
 {
     std::string path_to_folder = "./solomon_100"; // Ścieżka do katalogu z instancjami
-    std::vector<std::string> file_names;
+    cvrptw::SolverConfig config;
+    config.time_limit = 0.0;
+    config.fleet_seconds = 0.0;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--time" && a + 1 < argc) config.time_limit = std::stod(argv[++a]);
+        else if (arg == "--construction" && a + 1 < argc) config.construction = argv[++a];
+        else if (arg == "--fleet-time" && a + 1 < argc) config.fleet_seconds = std::stod(argv[++a]);
+        else if (arg == "--seed" && a + 1 < argc) config.seed = std::stoul(argv[++a]);
+        else path_to_folder = arg;
+    }
 
     // Sprawdzanie, czy katalog istnieje
-    if (!fs::exists(path_to_folder) || !fs::is_directory(path_to_folder)) // <-- POPRAWKA 1: Używa 'fs'
+    if (!fs::exists(path_to_folder) || !fs::is_directory(path_to_folder))
     {
         std::cerr << "Error: Folder not found: " << path_to_folder << "\n";
         return 1;
     }
 
-    // 1. Zbieramy *tylko nazwy plików* (tak jak robiłeś to wcześniej)
-    for (const auto &entry : fs::directory_iterator(path_to_folder)) // <-- POPRAWKA 1: Używa 'fs'
-    {
-        if (entry.is_regular_file())
-        {
-            file_names.push_back(entry.path().filename().string());
-        }
-    }
-
-    // Przetwarzamy każdy plik z wektora
-    for (const std::string &file_name : file_names)
-    { // Używam 'file_name' dla czytelności
-
-        // 2. Odtwarzamy pełną ścieżkę do pliku wejściowego
-        std::string full_path = path_to_folder + "/" + file_name;
-
-        // 3. Otwieramy plik wejściowy używając *nowej zmiennej* 'input_file'
-        std::ifstream input_file(full_path);
-        if (!input_file)
-        {
-            std::cerr << "Error opening file: " << full_path << "\n";
-            continue; // Pomiń ten plik, przejdź do następnego
-        }
+    std::vector<std::string> file_names;
+    for (const auto& entry : fs::directory_iterator(path_to_folder))
+        if (entry.is_regular_file()) file_names.push_back(entry.path().filename().string());
 
+    cvrptw::Solver solver(config);
+    for (const std::string& file_name : file_names)
+    {
         std::cout << "--- Processing: " << file_name << " ---\n";
-        // getting data
-        double amount, capacity;
-        std::string skip_line;
-        
-        // vvv POPRAWKA 2: Używamy 'input_file' do wczytywania vvv
-        for (int i = 0; i < 4; i++)
-            std::getline(input_file, skip_line);
-        input_file >> amount >> capacity;
-        for (int i = 0; i < 5; i++)
-            std::getline(input_file, skip_line);
-        
-        // matrix of customers
-        std::vector<Customer> customers;
-        int id, demand;
-        double x, y, ready, due, service;
-        while (input_file >> id >> x >> y >> demand >> ready >> due >> service)
-        {
-            customers.emplace_back(id, x, y, demand, ready, due, service);
-        }
-        // ^^^ POPRAWKA 2: Koniec zmian ^^^
-
-        input_file.close(); // Zamykamy plik
-
-        int n = customers.size();
-        if (n == 0)
-        {
-            std::cerr << "No customers in file: " << file_name << "\n";
-            continue; // Pomiń pusty plik
-        }
-
-        std::cout << n - 1 << " customers loaded.\n";
-        int depot_index = 0;
-
-        // Demand feasibility
-        bool demand_unfeasible = false;
-        for (int i = 1; i < n; i++)
-        {
-            if (customers[i].demand > capacity)
-            {
-                demand_unfeasible = true;
-                break;
-            }
-        }
-        
-        // POPRAWKA 3: Tworzymy unikalną nazwę pliku wyjściowego
-        std::string output_filename = "wynik_" + file_name;
-        std::ofstream out(output_filename);
-
-        if (demand_unfeasible)
-        {
-            out << "-1\n";
-            out.close();
-            std::cout << "Instance unfeasible (demand > capacity).\n\n";
-            continue; // Pomiń, przejdź do następnego pliku
-        }
-
-
-        // Distance matrix
-        std::vector<std::vector<double>> distances(n, std::vector<double>(n, 0.0));
-        for (int i = 0; i < n; i++)
-            for (int j = 0; j < n; j++)
-                distances[i][j] = euclidean_distance(customers[i], customers[j]);
-
-        // Heurystyka zachłanna
-
         auto start = std::chrono::high_resolution_clock::now();
-        std::vector<Route> routes;
-        std::vector<bool> visited(n, false);
-        visited[depot_index] = true;
-        int unvisited_count = n - 1;
-
-        while (unvisited_count > 0)
-        {
-            Route current_route;
-            current_route.load = 0;
-            int current_location_index = depot_index;
-            double current_time = 0.0;
-            bool can_add_more_to_this_route = true;
-            while (can_add_more_to_this_route)
-            {
-                int best_customer_index = -1;
-                double best_start_time = std::numeric_limits<double>::infinity();
-                for (int i = 1; i < n; i++)
-                {
-                    if (visited[i])
-                    {
-                        continue;
-                    }
-                    const Customer &customer = customers[i];
-                    if (current_route.load + customer.demand > capacity)
-                    {
-                        continue;
-                    }
-                    double travel_time = distances[current_location_index][i];
-                    double arrival_time = current_time + travel_time;
-                    double start_service_time = std::max(arrival_time, customer.ready);
-                    if (start_service_time > customer.due)
-                    {
-                        continue;
-                    }
-                    double departure_time = start_service_time + customer.service;
-                    double return_travel_time = distances[i][depot_index];
-                    double return_to_deport_time = departure_time + return_travel_time;
-
-                    if (return_to_deport_time > customers[depot_index].due)
-                    {
-                        continue;
-                    }
-                    if (start_service_time < best_start_time)
-                    {
-                        best_start_time = start_service_time;
-                        best_customer_index = i;
-                    }
-                }
-                if (best_customer_index != -1)
-                {
-                    const Customer &best_customer = customers[best_customer_index];
-                    current_route.sequence.push_back(best_customer_index);
-                    current_route.load += best_customer.demand;
-                    current_time = best_start_time + best_customer.service;
-                    current_location_index = best_customer_index;
-                    visited[best_customer_index] = true;
-                    unvisited_count--;
-                }
-                else
-                {
-                    can_add_more_to_this_route = false;
-                }
-            }
-
-            if (!current_route.sequence.empty())
-            {
-                routes.push_back(current_route);
-            }
-            else if (unvisited_count > 0)
-            {
-                break;
-            }
+        cvrptw::Instance instance;
+        try {
+            instance = cvrptw::Instance::from_file(path_to_folder + "/" + file_name);
         }
-        double total_cost = 0.0;
-        bool all_feasible = true;
-
-        if (unvisited_count > 0)
-        {
-            all_feasible = false;
-        }
-        else
-        {
-            for (auto &route : routes)
-            {
-                auto feasible_and_cost = route_feasible_and_cost(customers, depot_index, distances, route.sequence);
-                if (!feasible_and_cost.first)
-                {
-                    all_feasible = false;
-                    break;
-                }
-                route.cost = feasible_and_cost.second;
-                total_cost += route.cost;
-            }
-        }
-
-        if (!all_feasible)
-        {
-            out << "-1\n";
+        catch (const std::runtime_error& e) {
+            std::cerr << e.what() << "\n";
+            continue; // Pomiń ten plik, przejdź do następnego
         }
-        else
-        {
-            out.setf(std::ios::fixed);
-            out << std::setprecision(5);
-            out << routes.size() << " " << total_cost << "\n";
+        std::cout << instance.customers.size() - 1 << " customers loaded.\n";
 
-            for (auto &r : routes)
-            {
-                for (size_t k = 0; k < r.sequence.size(); k++)
-                {
-                    if (k > 0)
-                        out << " ";
-                    out << customers[r.sequence[k]].id;
-                }
-                out << "\n";
-            }
-        }
+        cvrptw::Solution solution = solver.solve(instance);
+        std::ofstream out("wynik_" + file_name);
+        solution.write(out);
         out.close();
-        auto end = std::chrono::high_resolution_clock::now();
-        
-        // POPRAWKA 4: Zmieniono "nanoseconds" na "microseconds"
-        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        if (!solution.feasible) std::cout << "Instance unfeasible.\n";
+        else std::cout << "Routes: " << solution.routes.size() << ", Cost: " << solution.cost << "\n";
+
+        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
         std::cout << "Time (microseconds): " << duration_us.count() << "\n\n";
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+#ifndef CVRPTW_PROTOCOL_H
+#define CVRPTW_PROTOCOL_H
+
+// Protokół serwera (server.cpp) i klienta (client.cpp) na gnieździe Unix.
+// Every message is a 4-byte big-endian length followed by that many bytes.
+//
+// request:  "key value" option lines (time-limit, seed, solver, construction, islands, threads,
+//           cross-len, neighbors, fleet-time, gap, penalty, exact, pool), then either
+//           "instance-hash <hex>" for an instance the server already holds, or an
+//           "instance" line followed by the instance in the Solomon text format
+// response: "ok <hex hash>" and the solution in the wynik.txt format followed by
+//           "lower_bound <cost>" and "seconds <s>" lines, or "error <message>"
+
+#include <cstdint>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace cvrptw {
+
+inline bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+inline bool read_all(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = ::read(fd, data, size);
+        if (got <= 0) return false;
+        data += got;
+        size -= got;
+    }
+    return true;
+}
+
+inline bool write_message(int fd, const std::string& payload) {
+    uint32_t size = payload.size();
+    unsigned char header[4] = { (unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size };
+    return write_all(fd, (const char*)header, 4) && write_all(fd, payload.data(), payload.size());
+}
+
+// messages above max_size are refused so a broken client cannot exhaust memory
+inline bool read_message(int fd, std::string& payload, uint32_t max_size = 256u << 20) {
+    unsigned char header[4];
+    if (!read_all(fd, (char*)header, 4)) return false;
+    uint32_t size = (uint32_t)header[0] << 24 | (uint32_t)header[1] << 16 | (uint32_t)header[2] << 8 | header[3];
+    if (size > max_size) return false;
+    payload.resize(size);
+    return read_all(fd, &payload[0], size);
+}
+
+} // namespace cvrptw
+
+#endif
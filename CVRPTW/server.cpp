@@ -0,0 +1,207 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <stdexcept>
+#include <csignal>
+#include <cstdio>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cvrptw.h"
+#include "protocol.h"
+
+// Serwer rozwiązujący instancje przez gniazdo Unix, protokół w protocol.h.
+// budowanie: g++ -O2 -std=c++17 -pthread server.cpp cvrptw.cpp -o server
+// użycie:    ./server /tmp/cvrptw.sock [--workers N] [--cache N] [--max-time S]
+
+// Prepared instances (distance matrix, neighbor lists, bounds) kept between requests,
+// least recently used dropped first. Keyed by instance hash and neighbor count.
+class InstanceCache {
+public:
+    explicit InstanceCache(size_t capacity) : capacity(capacity) {}
+
+    std::shared_ptr<const cvrptw::PreparedInstance> get(uint64_t hash, int neighbor_count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key(hash, neighbor_count));
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    void put(uint64_t hash, int neighbor_count, std::shared_ptr<const cvrptw::PreparedInstance> prepared) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t k = key(hash, neighbor_count);
+        auto it = index.find(k);
+        if (it != index.end()) entries.erase(it->second);
+        entries.emplace_front(k, std::move(prepared));
+        index[k] = entries.begin();
+        while (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+private:
+    static uint64_t key(uint64_t hash, int neighbor_count) { return hash ^ ((uint64_t)neighbor_count * 0x9E3779B97F4A7C15ull); }
+
+    size_t capacity;
+    std::mutex mutex;
+    std::list<std::pair<uint64_t, std::shared_ptr<const cvrptw::PreparedInstance>>> entries;
+    std::unordered_map<uint64_t, decltype(entries)::iterator> index;
+};
+
+struct ServerOptions {
+    int workers = std::max(1u, std::thread::hardware_concurrency());
+    size_t cache_size = 8;
+    double max_time = 299.0;
+};
+
+std::string to_hex(uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof buffer, "%016llx", (unsigned long long)value);
+    return buffer;
+}
+
+std::string handle_request(const std::string& request, InstanceCache& cache, const ServerOptions& options) {
+    std::istringstream in(request);
+    cvrptw::SolverConfig config;
+    // one request per worker, parallel searches only when asked for
+    config.threads = 1;
+    config.time_limit = std::min(10.0, options.max_time);
+    std::string line;
+    uint64_t hash = 0;
+    bool by_hash = false, inline_instance = false;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key, value;
+        fields >> key >> value;
+        if (key.empty()) continue;
+        if (key == "instance") {
+            inline_instance = true;
+            break;
+        }
+        if (key == "instance-hash") {
+            hash = std::stoull(value, nullptr, 16);
+            by_hash = true;
+        }
+        else if (key == "time-limit") config.time_limit = std::min(std::stod(value), options.max_time);
+        else if (key == "seed") config.seed = std::stoul(value);
+        else if (key == "solver") config.solver = value;
+        else if (key == "construction") config.construction = value;
+        else if (key == "islands") config.islands = std::stoi(value);
+        else if (key == "threads") config.threads = std::max(1, std::stoi(value));
+        else if (key == "cross-len") config.cross_max_len = std::stoi(value);
+        else if (key == "neighbors") config.neighbor_count = std::stoi(value);
+        else if (key == "fleet-time") config.fleet_seconds = std::stod(value);
+        else if (key == "gap") config.target_gap = std::stod(value);
+        else if (key == "penalty") config.penalty_mode = value == "1";
+        else if (key == "exact") config.exact_routes = value == "1";
+        else if (key == "pool") config.use_pool = value == "1";
+        else throw std::runtime_error("unknown option " + key);
+    }
+
+    std::shared_ptr<const cvrptw::PreparedInstance> prepared;
+    if (inline_instance) {
+        cvrptw::Instance instance = cvrptw::Instance::parse(in);
+        hash = instance.hash();
+        prepared = cache.get(hash, config.neighbor_count);
+        if (!prepared) {
+            prepared = std::make_shared<const cvrptw::PreparedInstance>(std::move(instance), config.neighbor_count);
+            cache.put(hash, config.neighbor_count, prepared);
+        }
+    }
+    else if (by_hash) {
+        prepared = cache.get(hash, config.neighbor_count);
+        if (!prepared) throw std::runtime_error("instance " + to_hex(hash) + " is not resident");
+    }
+    else throw std::runtime_error("no instance");
+
+    cvrptw::Solution solution = cvrptw::Solver(config).solve(*prepared);
+    std::ostringstream out;
+    out << "ok " << to_hex(hash) << "\n";
+    solution.write(out);
+    out << "lower_bound " << solution.lower_bound << "\n";
+    out << "seconds " << solution.seconds << "\n";
+    return out.str();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <socket path> [--workers N] [--cache N] [--max-time S]\n";
+        return 1;
+    }
+    std::string path = argv[1];
+    ServerOptions options;
+    for (int a = 2; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--workers" && a + 1 < argc) options.workers = std::max(1, std::stoi(argv[++a]));
+        else if (arg == "--cache" && a + 1 < argc) options.cache_size = std::max(1, std::stoi(argv[++a]));
+        else if (arg == "--max-time" && a + 1 < argc) options.max_time = std::stod(argv[++a]);
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof address.sun_path) {
+        std::cerr << "Cannot create socket.\n";
+        return 1;
+    }
+    path.copy(address.sun_path, path.size());
+    unlink(path.c_str());
+    if (bind(listener, (sockaddr*)&address, sizeof address) < 0 || listen(listener, 64) < 0) {
+        std::cerr << "Cannot listen on " << path << ".\n";
+        return 1;
+    }
+
+    InstanceCache cache(options.cache_size);
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<int> connections;
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options.workers; w++) {
+        workers.emplace_back([&]() {
+            while (true) {
+                int client;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_ready.wait(lock, [&] { return !connections.empty(); });
+                    client = connections.front();
+                    connections.pop_front();
+                }
+                std::string request, response;
+                if (cvrptw::read_message(client, request)) {
+                    try {
+                        response = handle_request(request, cache, options);
+                    }
+                    catch (const std::exception& e) {
+                        response = std::string("error ") + e.what() + "\n";
+                    }
+                    cvrptw::write_message(client, response);
+                }
+                close(client);
+            }
+        });
+    }
+    std::cout << "Listening on " << path << " with " << options.workers << " workers." << std::endl;
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            connections.push_back(client);
+        }
+        queue_ready.notify_one();
+    }
+}